@@ -13,8 +13,21 @@
 #include <linux/hwmon-sysfs.h>
 #include <linux/mfd/eiois200.h>
 
+#include "eiois200-hwmon_kunit.h"
+
 #define MAX_DEV 128
 #define MAX_NAME 32
+#define SEN_MAX	 8
+#define LIMIT_TTL 1000 /* Cache lifetime of limits in msec */
+#define TYPE_TTL  60000 /* Cache lifetime of sensor type in msec */
+
+/* Attribute index: sensor type, channel, sen_info item and type id byte */
+#define SEN_INDEX(type, ch, item, id) \
+	((type) << 24 | (ch) << 16 | (item) << 8 | (id))
+#define SEN_TYPE(idx)	((enum _sen_type)((idx) >> 24))
+#define SEN_CH(idx)	(((idx) >> 16) & 0xFF)
+#define SEN_ITEM(idx)	(((idx) >> 8) & 0xFF)
+#define SEN_ID(idx)	((idx) & 0xFF)
 
 static uint timeout;
 module_param(timeout, uint, 0444);
@@ -23,10 +36,17 @@ MODULE_PARM_DESC(timeout,
 
 static struct eiois200_dev *eiois200_dev;
 
-static struct _hwmon_dev {
+struct _hwmon_dev {
 	struct device *dev;
 	struct regmap *regmap;
-} *hwmon_dev = NULL;
+	u8 ec;
+
+	char devname[MAX_DEV][MAX_NAME];
+	struct sensor_device_attribute devattrs[MAX_DEV];
+	struct attribute *attrs[MAX_DEV + 1];
+	struct attribute_group group;
+	const struct attribute_group *groups[2];
+};
 
 enum _sen_type {
 	NONE,
@@ -119,66 +139,56 @@ static struct {
 	}
 };
 
-static struct {
-	enum _sen_type type;
-	u8   ctrl;
-	int  size;
-	bool write;
-
-} ctrl_para[] = {
-	{ NONE,     0x00, 0, false },
-
-	{ VOLTAGE,  0x00, 1, false }, { VOLTAGE,  0x01, 1, false },
-	{ VOLTAGE,  0x10, 2, false }, { VOLTAGE,  0x11, 2, false },
-	{ VOLTAGE,  0x12, 2, false },
-
-	{ CURRENT,  0x00, 1, false }, { CURRENT,  0x01, 1, false },
-	{ CURRENT,  0x10, 2, false }, { CURRENT,  0x11, 2, false },
-	{ CURRENT,  0x12, 2, false },
-
-	{ TEMP,	    0x00, 2, false }, { TEMP,	  0x01, 1, false },
-	{ TEMP,     0x04, 1, false }, { TEMP,	  0x10, 2, false },
-	{ TEMP,     0x11, 2, false }, { TEMP,	  0x12, 2, false },
-	{ TEMP,     0x21, 2, false }, { TEMP,	  0x41, 2, false },
-
-	{ PWM,      0x00, 1, false }, { PWM,	  0x10, 1, true  },
-	{ PWM,      0x11, 1, true  }, { PWM,	  0x12, 4, true  },
-
-	{ TACHO,    0x00, 1, false }, { TACHO,	  0x01, 1, false },
-	{ TACHO,    0x10, 4, true  },
-
-	{ FAN,      0x00, 1, false }, { FAN,	  0x01, 1, false },
-	{ FAN,      0x03, 1, true  }, { FAN,	  0x1A, 2, false },
-
-	{ CASEOPEN, 0x00, 1, false }, { CASEOPEN, 0x02, 1, true  },
+/*
+ * Payload sizes of the state (0x00) and type (0x01) controls and of each
+ * sen_info item control. Indexed directly, 0 for not supported.
+ */
+static const struct {
+	u8 state;
+	u8 type;
+	u8 item[16];
+} sen_size[] = {
+	[VOLTAGE]  = { 1, 1, { 0, 2, 2, 2 } },
+	[CURRENT]  = { 1, 1, { 0, 2, 2, 2 } },
+	[TEMP]	   = { 2, 1, { 0, 2, 2, 2, 2, 2 } },
+	[PWM]	   = { 1, 0, { 0, 1, 4 } },
+	[TACHO]	   = { 1, 1, { 0, 4 } },
+	[FAN]	   = { 1, 1, { 0, 2 } },
+	[CASEOPEN] = { 1, 0, { 0, 1 } },
 };
 
-static int para_idx(enum _sen_type type, u8 ctrl)
+static int pmc_read_op(struct _hwmon_dev *hwmon, struct pmc_op *op,
+		       enum _sen_type type, u8 dev_id, u8 ctrl, u8 size,
+		       void *data)
 {
-	int i;
-
-	for (i = 1 ; i < ARRAY_SIZE(ctrl_para) ; i++)
-		if (type == ctrl_para[i].type &&
-		    ctrl == ctrl_para[i].ctrl)
-			return i;
-
-	return 0;
-}
+	if (size == 0)
+		return -EINVAL;
 
-static int pmc_read(enum _sen_type type, u8 dev_id, u8 ctrl, void *data)
-{
-	int idx = para_idx(type, ctrl);
-	struct   pmc_op op = {
+	*op = (struct pmc_op) {
 		 .cmd       = sen_info[type].cmd + 1,
 		 .control   = ctrl,
 		 .device_id = dev_id,
-		 .size	    = ctrl_para[idx].size,
+		 .size	    = size,
 		 .payload   = (u8 *)data,
+		 .chip      = hwmon->ec,
 		 .timeout   = timeout,
+		 .client    = EIOIS200_CLIENT_HWMON,
 	};
 
-	if (idx == 0)
-		return -EINVAL;
+	return 0;
+}
+
+static int pmc_read_ttl(struct _hwmon_dev *hwmon, enum _sen_type type,
+			u8 dev_id, u8 ctrl, u8 size, void *data, u16 ttl)
+{
+	struct pmc_op op;
+	int ret;
+
+	ret = pmc_read_op(hwmon, &op, type, dev_id, ctrl, size, data);
+	if (ret)
+		return ret;
+
+	op.ttl = ttl;
 
 	return eiois200_core_pmc_operation(NULL, &op);
 }
@@ -186,21 +196,48 @@ static int pmc_read(enum _sen_type type, u8 dev_id, u8 ctrl, void *data)
 static ssize_t show(struct device *dev, struct device_attribute *attr,
 		    char *buf)
 {
+	struct _hwmon_dev *hwmon = dev_get_drvdata(dev);
 	int ret;
 	int idx = to_sensor_dev_attr(attr)->index;
-	enum _sen_type type = (enum _sen_type)idx >> 24;
-	int shift = (idx >> 16) & 0xFF;
-	int item = (idx >> 8) & 0xFF;
-	int id = idx  & 0xFF;
+	enum _sen_type type = SEN_TYPE(idx);
+	int shift = SEN_CH(idx);
+	int item = SEN_ITEM(idx);
+	int id = SEN_ID(idx);
 	u32 data = 0;
+	u16 snap;
+	struct pmc_op op;
+
+	/* Live inputs shared with the thermal and fan drivers */
+	if (item == 1 && (type == TEMP || type == VOLTAGE)) {
+		ret = eiois200_core_snapshot(NULL, hwmon->ec, type == TEMP ?
+					     EIOIS200_SNAP_TEMP :
+					     EIOIS200_SNAP_VOLT,
+					     shift, &snap,
+					     EIOIS200_CLIENT_HWMON);
+		if (ret)
+			return ret;
+
+		return sprintf(buf, "%d\n",
+			       (snap + sen_info[type].shift) *
+			       sen_info[type].multi[item]);
+	}
 
 	switch (item) {
 	case 0:
 		return sprintf(buf, "%s\n", sen_info[type].labels[id]);
 
 	default:
-		ret = pmc_read(type, shift,
-			       sen_info[type].ctrl[item], &data);
+		ret = pmc_read_op(hwmon, &op, type, shift,
+				  sen_info[type].ctrl[item],
+				  sen_size[type].item[item], &data);
+		if (ret)
+			return ret;
+
+		/* Item 1 is the live input, others are rarely changed limits */
+		if (item != 1)
+			op.ttl = LIMIT_TTL;
+
+		ret = eiois200_core_pmc_operation(NULL, &op);
 		if (ret)
 			return ret;
 
@@ -217,20 +254,7 @@ static struct sensor_device_attribute default_attr = {
 	.dev_attr.show = show,
 };
 
-static char devname[MAX_DEV][MAX_NAME];
-static struct sensor_device_attribute devattrs[MAX_DEV];
-static struct attribute *attrs[MAX_DEV];
-
-static struct attribute_group group = {
-	.attrs = attrs,
-};
-
-static const struct attribute_group *groups[] = {
-	&group,
-	NULL
-};
-
-static int hwmon_init(void)
+static int hwmon_init(struct _hwmon_dev *hwmon)
 {
 	enum _sen_type type;
 	u8 i, j, data[16];
@@ -239,14 +263,32 @@ static int hwmon_init(void)
 
 	for (type = VOLTAGE ; type <= CASEOPEN ; type++) {
 		int cnt = 1;
+		u16 state[SEN_MAX] = { 0 };
+		int status[SEN_MAX];
+		struct pmc_op ops[SEN_MAX];
+
+		/* Read all channels' state of this type in one batch */
+		for (i = 0 ; i < sen_info[type].max ; i++) {
+			pmc_read_op(hwmon, &ops[i], type, i, 0x00,
+				    sen_size[type].state, &state[i]);
+			ops[i].priority = PMC_PRIO_BACKGROUND;
+		}
+
+		/* A failed channel is skipped below by its own status */
+		ret = eiois200_core_pmc_batch(NULL, ops, sen_info[type].max,
+					      status);
+		if (eiois200_batch_rejected(ret, status, sen_info[type].max)) {
+			pr_info("read %s state error\n", sen_info[type].name);
+			continue;
+		}
 
 		for (i = 0 ; i < sen_info[type].max ; i++) {
-			if (pmc_read(type, i, 0x00, data) ||
-			    (data[0] & 0x01) == 0)
+			if (status[i] || (state[i] & 0x01) == 0)
 				continue;
 
 			memset(data, 0, sizeof(data));
-			ret = pmc_read(type, i, 0x01, data);
+			ret = pmc_read_ttl(hwmon, type, i, 0x01,
+					   sen_size[type].type, data, TYPE_TTL);
 			if (ret != 0 && ret != -EINVAL) {
 				pr_info("read type id error\n");
 				continue;
@@ -256,13 +298,14 @@ static int hwmon_init(void)
 				if (sen_info[type].item[j][0] == 0)
 					continue;
 
-				devattrs[sum] = default_attr;
-				attrs[sum] = &devattrs[sum].dev_attr.attr;
-				devattrs[sum].dev_attr.attr.name = devname[sum];
-				devattrs[sum].index = (type << 24) | (i << 16) |
-						      (j    <<  8) | data[0];
+				hwmon->devattrs[sum] = default_attr;
+				hwmon->attrs[sum] = &hwmon->devattrs[sum].dev_attr.attr;
+				hwmon->devattrs[sum].dev_attr.attr.name =
+					hwmon->devname[sum];
+				hwmon->devattrs[sum].index =
+					SEN_INDEX(type, i, j, data[0]);
 
-				sprintf(devname[sum],
+				sprintf(hwmon->devname[sum],
 					"%s%d_%s",
 					sen_info[type].name, cnt,
 					sen_info[type].item[j]);
@@ -280,6 +323,7 @@ static int hwmon_init(void)
 static int hwmon_probe(struct platform_device *pdev)
 {
 	struct device *dev =  &pdev->dev;
+	struct _hwmon_dev *hwmon_dev;
 
 	eiois200_dev = dev_get_drvdata(dev->parent);
 	if (!eiois200_dev) {
@@ -287,10 +331,17 @@ static int hwmon_probe(struct platform_device *pdev)
 		return -ENODEV;
 	}
 
-	if (!hwmon_init())
+	hwmon_dev = devm_kzalloc(dev, sizeof(struct _hwmon_dev), GFP_KERNEL);
+	if (!hwmon_dev)
+		return -ENOMEM;
+
+	hwmon_dev->ec = eiois200_cell_chip(dev);
+
+	if (!hwmon_init(hwmon_dev))
 		return -ENODEV;
 
-	hwmon_dev = devm_kzalloc(dev, sizeof(struct _hwmon_dev), GFP_KERNEL);
+	hwmon_dev->group.attrs = hwmon_dev->attrs;
+	hwmon_dev->groups[0]   = &hwmon_dev->group;
 
 	hwmon_dev->regmap      = dev_get_regmap(dev->parent, NULL);
 	if (!hwmon_dev->regmap)
@@ -301,19 +352,59 @@ static int hwmon_probe(struct platform_device *pdev)
 	hwmon_dev->dev = devm_hwmon_device_register_with_groups(dev,
 								KBUILD_MODNAME,
 								hwmon_dev,
-								groups);
+								hwmon_dev->groups);
 	return PTR_ERR_OR_ZERO(hwmon_dev->dev);
 }
 
 static struct platform_driver hwmon_driver = {
+	.probe	= hwmon_probe,
 	.driver = {
-		.owner = THIS_MODULE,
-		.name  = KBUILD_MODNAME,
+		.owner	    = THIS_MODULE,
+		.name	    = KBUILD_MODNAME,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	}
 };
-module_platform_driver_probe(hwmon_driver, hwmon_probe);
+module_platform_driver(hwmon_driver);
 
 MODULE_AUTHOR("Adavantech");
 MODULE_DESCRIPTION("Hardware monitor driver for Advantech EIO-IS200 embedded controller");
 MODULE_LICENSE("GPL v2");
 
+#ifdef EIOIS200_KUNIT
+/* Hooks for eiois200-hwmon_test, see eiois200-hwmon_kunit.h */
+int eiois200_kunit_hwmon_index(int type, u8 ch, u8 item, u8 id)
+{
+	return SEN_INDEX(type, ch, item, id);
+}
+EXPORT_SYMBOL_GPL(eiois200_kunit_hwmon_index);
+
+void eiois200_kunit_hwmon_unpack(int index, int *type, u8 *ch, u8 *item,
+				 u8 *id)
+{
+	*type = SEN_TYPE(index);
+	*ch   = SEN_CH(index);
+	*item = SEN_ITEM(index);
+	*id   = SEN_ID(index);
+}
+EXPORT_SYMBOL_GPL(eiois200_kunit_hwmon_unpack);
+
+int eiois200_kunit_hwmon_sen(int type, int item,
+			     struct eiois200_kunit_sen *sen)
+{
+	if (type <= NONE || type > CASEOPEN ||
+	    item < 0 || item >= ARRAY_SIZE(sen_info->item))
+		return -EINVAL;
+
+	sen->name	= sen_info[type].name;
+	sen->item	= sen_info[type].item[item];
+	sen->max	= sen_info[type].max;
+	sen->batch	= SEN_MAX;
+	sen->ctrl	= sen_info[type].ctrl[item];
+	sen->state_size = sen_size[type].state;
+	sen->type_size	= sen_size[type].type;
+	sen->size	= sen_size[type].item[item];
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(eiois200_kunit_hwmon_sen);
+#endif
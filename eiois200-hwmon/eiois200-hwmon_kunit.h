@@ -0,0 +1,34 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Hooks of eiois200-hwmon for the eiois200-hwmon_test KUnit module.
+ *
+ * They are only built and exported with make KUNIT=y and give the test
+ * the attribute index encoding and the sensor tables.
+ *
+ * Copyright (C) 2023 Advantech Co., Ltd.
+ */
+
+#ifndef _EIOIS200_HWMON_KUNIT_H_
+#define _EIOIS200_HWMON_KUNIT_H_
+
+#include <linux/types.h>
+
+/* One sen_info item of a sensor type and its payload sizes */
+struct eiois200_kunit_sen {
+	const char *name;	/* sensor type */
+	const char *item;	/* "" if the item does not exist */
+	u8 max;			/* channels */
+	u8 batch;		/* channels hwmon_init() reads in one batch */
+	u8 ctrl;
+	u8 state_size;
+	u8 type_size;
+	u8 size;		/* payload of the item */
+};
+
+int eiois200_kunit_hwmon_index(int type, u8 ch, u8 item, u8 id);
+void eiois200_kunit_hwmon_unpack(int index, int *type, u8 *ch, u8 *item,
+				 u8 *id);
+int eiois200_kunit_hwmon_sen(int type, int item,
+			     struct eiois200_kunit_sen *sen);
+
+#endif
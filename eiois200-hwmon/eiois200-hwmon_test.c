@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit tests of the EIO-IS200 hardware monitor driver, built as the
+ * eiois200-hwmon_test module with make KUNIT=y.
+ *
+ * The cases only cover the attribute index encoding and the sensor
+ * tables, so they need neither the EC nor the software EC model.
+ *
+ * Copyright (C) 2023 Advantech Co., Ltd.
+ */
+
+#include <linux/errno.h>
+#include <linux/module.h>
+#include <kunit/test.h>
+
+#include "eiois200-hwmon_kunit.h"
+
+#define SEN_TYPES	8	/* Including NONE */
+#define SEN_ITEMS	16
+
+static void check_index(struct kunit *test, int type, u8 ch, u8 item)
+{
+	static const u8 ids[] = { 0x00, 0x01, 0x5A, 0xFF };
+	int i, index, got_type;
+	u8 got_ch, got_item, got_id;
+
+	for (i = 0; i < ARRAY_SIZE(ids); i++) {
+		index = eiois200_kunit_hwmon_index(type, ch, item, ids[i]);
+		KUNIT_EXPECT_GE(test, index, 0);
+
+		eiois200_kunit_hwmon_unpack(index, &got_type, &got_ch,
+					    &got_item, &got_id);
+		KUNIT_EXPECT_EQ(test, got_type, type);
+		KUNIT_EXPECT_EQ(test, got_ch, ch);
+		KUNIT_EXPECT_EQ(test, got_item, item);
+		KUNIT_EXPECT_EQ(test, got_id, ids[i]);
+	}
+}
+
+/* show() finds the sensor hwmon_init() packed into the attribute index */
+static void test_index(struct kunit *test)
+{
+	struct eiois200_kunit_sen sen;
+	int type;
+	u8 ch, item;
+
+	for (type = 1; type < SEN_TYPES; type++) {
+		KUNIT_ASSERT_EQ(test, eiois200_kunit_hwmon_sen(type, 0, &sen),
+				0);
+
+		for (ch = 0; ch < sen.max; ch++)
+			for (item = 0; item < SEN_ITEMS; item++)
+				check_index(test, type, ch, item);
+	}
+}
+
+static void test_sen_range(struct kunit *test)
+{
+	struct eiois200_kunit_sen sen;
+
+	KUNIT_EXPECT_EQ(test, eiois200_kunit_hwmon_sen(0, 0, &sen), -EINVAL);
+	KUNIT_EXPECT_EQ(test, eiois200_kunit_hwmon_sen(SEN_TYPES, 0, &sen),
+			-EINVAL);
+	KUNIT_EXPECT_EQ(test, eiois200_kunit_hwmon_sen(1, -1, &sen), -EINVAL);
+	KUNIT_EXPECT_EQ(test, eiois200_kunit_hwmon_sen(1, SEN_ITEMS, &sen),
+			-EINVAL);
+}
+
+/*
+ * Every item but the label reads a value that fits the u32 of show(), and
+ * the sizes table has no entry for an item sen_info does not name.
+ */
+static void test_sen_size(struct kunit *test)
+{
+	struct eiois200_kunit_sen sen;
+	int type, item, ret;
+
+	for (type = 1; type < SEN_TYPES; type++) {
+		for (item = 0; item < SEN_ITEMS; item++) {
+			ret = eiois200_kunit_hwmon_sen(type, item, &sen);
+			KUNIT_ASSERT_EQ(test, ret, 0);
+
+			if (!sen.item[0]) {
+				KUNIT_EXPECT_EQ_MSG(test, sen.size, 0, "%s %d",
+						    sen.name, item);
+				continue;
+			}
+
+			if (item == 0) {
+				KUNIT_EXPECT_STREQ(test, sen.item, "label");
+				KUNIT_EXPECT_EQ(test, sen.ctrl, 0xFF);
+				KUNIT_EXPECT_EQ(test, sen.size, 0);
+				continue;
+			}
+
+			KUNIT_EXPECT_TRUE_MSG(test, sen.size == 1 ||
+					      sen.size == 2 || sen.size == 4,
+					      "%s_%s size %d", sen.name,
+					      sen.item, sen.size);
+		}
+
+		KUNIT_EXPECT_TRUE_MSG(test, sen.state_size == 1 ||
+				      sen.state_size == 2, "%s", sen.name);
+		KUNIT_EXPECT_LE_MSG(test, sen.type_size, 1, "%s", sen.name);
+		KUNIT_EXPECT_LE_MSG(test, sen.max, sen.batch, "%s", sen.name);
+	}
+}
+
+static struct kunit_case eiois200_hwmon_test_cases[] = {
+	KUNIT_CASE(test_index),
+	KUNIT_CASE(test_sen_range),
+	KUNIT_CASE(test_sen_size),
+	{}
+};
+
+static struct kunit_suite eiois200_hwmon_test_suite = {
+	.name	    = "eiois200_hwmon",
+	.test_cases = eiois200_hwmon_test_cases,
+};
+kunit_test_suite(eiois200_hwmon_test_suite);
+
+MODULE_AUTHOR("Wenkai <advantech.susiteam@gmail.com>");
+MODULE_DESCRIPTION("KUnit tests of the Advantech EIO-IS200 hwmon driver");
+MODULE_LICENSE("GPL v2");
@@ -31,6 +31,12 @@
 
 #define USE_DEFAULT		-1
 #define THERMAL_MAX		100
+#define CACHE_TTL		60000 /* millisecond */
+
+/* Backlight data: EC index and backlight id on that EC */
+#define BL_DATA(ec, id)		((((long)(ec)) << 8) | (id))
+#define BL_EC(data)		(((long)(data)) >> 8)
+#define BL_ID(data)		(((long)(data)) & 0xFF)
 
 union bl_status {
 	struct {
@@ -62,25 +68,26 @@ static int timeout;
 module_param(timeout, int, 0444);
 MODULE_PARM_DESC(timeout, "Set PMC command timeout value.\n");
 
-static int pmc_cmd(struct device *dev, u8 cmd, u8 ctrl, u8 id, void *data)
-{
-	struct pmc_op op = {
-		.cmd       = cmd,
-		.control   = ctrl,
-		.device_id = id,
-		.size	   = ctrl == BL_CTRL_FREQ ? 4 : 1,
-		.payload   = (u8 *)data,
-		.timeout   = timeout,
-	};
+/* Target of a typed accessor, the payload size comes from the value type */
+#define BL_OP(_cmd, ctl, id, _ttl) (&(const struct pmc_op) {	\
+	.cmd       = _cmd,				\
+	.control   = ctl,				\
+	.device_id = BL_ID(id),				\
+	.chip	   = BL_EC(id),				\
+	.timeout   = timeout,				\
+	.ttl	   = _ttl,				\
+	.client	   = EIOIS200_CLIENT_BL,		\
+})
 
-	return eiois200_core_pmc_operation(dev, &op);
-}
+#define PMC_WRITE(dev, ctrl, id, val) \
+	eiois200_pmc_write(dev, BL_OP(PMC_BL_WRITE, ctrl, id, 0), val)
 
-#define PMC_WRITE(dev, ctrl, id, data) \
-	pmc_cmd(dev, PMC_BL_WRITE, ctrl, id, data)
+#define PMC_READ(dev, ctrl, id, val) \
+	eiois200_pmc_read(dev, BL_OP(PMC_BL_READ, ctrl, id, 0), val)
 
-#define PMC_READ(dev, ctrl, id, data) \
-	pmc_cmd(dev, PMC_BL_READ, ctrl, id, data)
+/* Read a value that rarely changes through the core read cache */
+#define PMC_READ_CACHED(dev, ctrl, id, val) \
+	eiois200_pmc_read(dev, BL_OP(PMC_BL_READ, ctrl, id, CACHE_TTL), val)
 
 static int bl_update_status(struct backlight_device *bl)
 {
@@ -90,18 +97,18 @@ static int bl_update_status(struct backlight_device *bl)
 	u8 sw = bl->props.power == FB_BLANK_UNBLANK;
 
 	/* Setup PWM duty */
-	ret = PMC_WRITE(dev, BL_CTRL_DUTY, id, &bl->props.brightness);
+	ret = PMC_WRITE(dev, BL_CTRL_DUTY, id, (u8)bl->props.brightness);
 	if (ret)
 		return ret;
 
 	/* Setup backlight enable pin */
-	return PMC_WRITE(dev, BL_CTRL_ENABLE, id, &sw);
+	return PMC_WRITE(dev, BL_CTRL_ENABLE, id, sw);
 }
 
 static int bl_get_brightness(struct backlight_device *bl)
 {
 	u8 duty = 0;
-	int id = (long)bl_get_data(bl);
+	long id = (long)bl_get_data(bl);
 	int ret;
 
 	ret = PMC_READ(&bl->dev, BL_CTRL_DUTY, id, &duty);
@@ -117,49 +124,58 @@ static const struct backlight_ops bl_ops = {
 	.options	= BL_CORE_SUSPENDRESUME,
 };
 
-static int bl_init(struct device *dev, int id,
+static int bl_init(struct device *dev, long id,
 		   struct backlight_properties *props)
 {
 	int ret = 0;
-	u8 enabled;
+	u8 enabled, duty, invert;
+	u32 freq;
 	union bl_status status = { .value = 0 };
 
 	/* Check EC supported backlight or not */
-	ret = PMC_READ(dev, BL_CTRL_STATUS, id, &status);
+	ret = PMC_READ(dev, BL_CTRL_STATUS, id, &status.value);
 	if (ret)
 		return ret;
 
 	if (!status.avail) {
-		dev_dbg(dev, "eiois200_bl%d hardware report disabled.\n", id);
+		dev_dbg(dev, "eiois200_bl%ld hardware report disabled.\n",
+			BL_ID(id));
 		return -ENXIO;
 	}
 
 	/* Read duty */
-	ret = PMC_READ(dev, BL_CTRL_DUTY, id, &props->brightness);
+	ret = PMC_READ(dev, BL_CTRL_DUTY, id, &duty);
+	if (!ret)
+		props->brightness = duty;
 
 	/* Invert PWM */
 	dev_dbg(dev, "bri_invert=%d\n", bri_invert);
 	if (bri_invert > USE_DEFAULT)
-		ret = PMC_WRITE(dev, BL_CTRL_INVERT, id, &bri_invert);
+		ret = PMC_WRITE(dev, BL_CTRL_INVERT, id, (u8)bri_invert);
 
-	bri_invert = 0;
-	ret = PMC_READ(dev, BL_CTRL_INVERT, id, &bri_invert);
+	/* Read back per backlight, the module params stay what was asked */
+	invert = 0;
+	ret = PMC_READ_CACHED(dev, BL_CTRL_INVERT, id, &invert);
+	dev_dbg(dev, "eiois200_bl%ld PWM invert=%u\n", BL_ID(id), invert);
 
 	/* Setup freq */
 	dev_dbg(dev, "bri_freq=%d\n", bri_freq);
 	if (bri_freq != USE_DEFAULT)
-		ret = PMC_WRITE(dev, BL_CTRL_FREQ, id, &bri_freq);
+		ret = PMC_WRITE(dev, BL_CTRL_FREQ, id, (u32)bri_freq);
 
-	PMC_READ(dev, BL_CTRL_FREQ, id, &bri_freq);
+	freq = 0;
+	PMC_READ(dev, BL_CTRL_FREQ, id, &freq);
+	dev_dbg(dev, "eiois200_bl%ld PWM freq=%u\n", BL_ID(id), freq);
 
 	/* Invert enable pin*/
 	dev_dbg(dev, "bl_power_invert=%d\n", bl_power_invert);
-	if (bl_power_invert >= USE_DEFAULT)
+	if (bl_power_invert > USE_DEFAULT)
 		ret = PMC_WRITE(dev, BL_CTRL_ENABLE_INVERT,
-				id, &bl_power_invert);
+				id, (u8)bl_power_invert);
 
-	bl_power_invert = 0;
-	ret = PMC_READ(dev, BL_CTRL_ENABLE_INVERT, id, &bl_power_invert);
+	invert = 0;
+	ret = PMC_READ(dev, BL_CTRL_ENABLE_INVERT, id, &invert);
+	dev_dbg(dev, "eiois200_bl%ld enable invert=%u\n", BL_ID(id), invert);
 
 	/* Read power state */
 	ret = PMC_READ(dev, BL_CTRL_ENABLE, id, &enabled);
@@ -171,7 +187,7 @@ static int bl_init(struct device *dev, int id,
 	return ret;
 }
 
-static struct backlight_properties props = {
+static const struct backlight_properties default_props = {
 	.type = BACKLIGHT_RAW,
 	.max_brightness = THERMAL_MAX,
 	.power = FB_BLANK_UNBLANK,
@@ -184,6 +200,7 @@ static int bl_probe(struct platform_device *pdev)
 	int ret = -ENXIO;
 	struct device *dev =  &pdev->dev;
 	struct backlight_device *bl;
+	u8 ec = eiois200_cell_chip(dev);
 
 	/* Confirm if eiois200_core exist */
 	if (!dev_get_drvdata(dev->parent)) {
@@ -193,14 +210,17 @@ static int bl_probe(struct platform_device *pdev)
 
 	/* Init and register 2 backlights */
 	for (id = 0; id < BL_MAX; id++) {
+		struct backlight_properties props = default_props;
 		char name[256];
 
-		ret = bl_init(dev, id, &props);
+		ret = bl_init(dev, BL_DATA(ec, id), &props);
 		if (ret)
 			continue;
 
-		sprintf(name, "%s%ld", pdev->name, id);
-		bl = devm_backlight_device_register(dev, name, dev, (void *)id,
+		/* Backlights of the sub chip follow those of the main chip */
+		sprintf(name, "%s%ld", pdev->name, ec * BL_MAX + id);
+		bl = devm_backlight_device_register(dev, name, dev,
+						    (void *)BL_DATA(ec, id),
 						    &bl_ops, &props);
 		if (IS_ERR(bl))
 			return PTR_ERR(bl);
@@ -212,11 +232,13 @@ static int bl_probe(struct platform_device *pdev)
 }
 
 static struct platform_driver bl_driver = {
+	.probe	= bl_probe,
 	.driver = {
-		.name  = "eiois200_bl",
+		.name	    = "eiois200_bl",
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	}
 };
-module_platform_driver_probe(bl_driver, bl_probe);
+module_platform_driver(bl_driver);
 
 MODULE_AUTHOR("Adavantech");
 MODULE_DESCRIPTION("GPIO driver for Advantech EIO-IS200 embedded controller");
@@ -0,0 +1,3537 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Advantech EIO-IS200 Series EC base Driver
+ *
+ * This driver provides an interface to access the EIO-IS200 Series EC
+ * firmware via its own Power Management Channel (PMC) for subdrivers:
+ *
+ * A system may have one or two independent EIO-IS200s. Each EC has its own
+ * PMC command/data port pair and its own lock, so the two chips can be
+ * driven in parallel. The PNP index/data sequences are serialized by a
+ * separate lock shared with the sub-drivers.
+ *
+ * PMC commands are queued to a per-chip worker. eiois200_core_pmc_submit()
+ * returns immediately and signals completion by callback, while
+ * eiois200_core_pmc_operation() and eiois200_core_pmc_batch() queue and wait.
+ * A single read identical to one still queued joins it instead of running
+ * the same EC transaction again.
+ *
+ * Copyright (C) 2023 Advantech Co., Ltd.
+ * Author: Wenkai <advantech.susiteam@gmail.com>
+ */
+
+#include <linux/atomic.h>
+#include <linux/completion.h>
+#include <linux/debugfs.h>
+#include <linux/delay.h>
+#include <linux/hashtable.h>
+#include <linux/interrupt.h>
+#include <linux/isa.h>
+#include <linux/list.h>
+#include <linux/math64.h>
+#include <linux/mfd/core.h>
+#include <linux/miscdevice.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/platform_device.h>
+#include <linux/ratelimit.h>
+#include <linux/regmap.h>
+#include <linux/seq_file.h>
+#include <linux/seqlock.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/sysfs.h>
+#include <linux/time.h>
+#include <linux/uaccess.h>
+#include <linux/version.h>
+#include <linux/workqueue.h>
+#include <linux/mfd/eiois200.h>
+#include <uapi/linux/eiois200.h>
+
+#define CREATE_TRACE_POINTS
+#include "eiois200_trace.h"
+#include "eiois200_kunit.h"
+#include "eiois200_sim.h"
+
+#define TIMEOUT_MAX     (10 * USEC_PER_SEC)
+#define TIMEOUT_MIN	200
+#define SLEEP_MAX	200
+#define SLEEP_MIN	10
+#define SPIN_MAX	10
+#define DEFAULT_TIMEOUT 5000
+#define LEARN_LOOPS	8
+#define LEARN_MAX	(4 * DEFAULT_TIMEOUT)
+#define DEFAULT_BUDGET	20000
+#define DEFAULT_FAIL_MAX 3
+#define DEFAULT_RECOVER	1000
+#define BENCH_LOOPS	1000
+#define HIST_NUM	16
+#define CMD_NUM		256
+#define ACPIRAM_SIZE	256
+#define ACPIRAM_CHUNK	32
+#define DEFAULT_SNAPSHOT 1000
+#define SNAP_IDLE	10
+#define DEFAULT_SAVE	5000
+#define CACHE_BITS	6
+#define CACHE_MAX	256
+#define CACHE_KEY(chip, cmd, ctrl, id) \
+	((u32)(chip) << 24 | (u32)(cmd) << 16 | (u32)(ctrl) << 8 | (id))
+
+/**
+ * Timeout: Default timeout in microseconds when a PMC command's
+ * timeout is unspecified. 0 (the default) uses the timeout learned from
+ * the measured EC response time of each chip, see pmc_learn_update().
+ * PMC command responses typically range from 200us to 2ms. In some
+ * cases, responses are longer. In such situations, please adding the
+ * timeout parameter loading related sub-drivers or this core driver
+ * (not recommended).
+ */
+static uint timeout;
+module_param(timeout, uint, 0444);
+MODULE_PARM_DESC(timeout,
+		 "Default PMC command timeout in usec, 0 to learn it.\n");
+
+/**
+ * budget: Overall deadline in microseconds for one PMC transaction. The
+ * per-byte waits draw from it, so a wedged EC holds the chip lock for at
+ * most max(budget, pmc_op.timeout) instead of timeout per byte.
+ */
+static uint budget = DEFAULT_BUDGET;
+module_param(budget, uint, 0644);
+MODULE_PARM_DESC(budget,
+		 "PMC transaction deadline in usec.\n");
+
+/**
+ * fail_max: Consecutive PMC timeouts after which a chip is marked failed.
+ * A failed chip rejects new requests with -EAGAIN until a background probe
+ * every recover_ms milliseconds gets an answer again. 0 disables it.
+ */
+static uint fail_max = DEFAULT_FAIL_MAX;
+module_param(fail_max, uint, 0644);
+MODULE_PARM_DESC(fail_max,
+		 "Consecutive PMC timeouts before fast-fail. 0 to disable.\n");
+
+static uint recover_ms = DEFAULT_RECOVER;
+module_param(recover_ms, uint, 0644);
+MODULE_PARM_DESC(recover_ms,
+		 "Recovery probe interval of a failed chip in msec.\n");
+
+/**
+ * ioctl_writes: PMC write commands /dev/eiois200 may send, e.g. 0x20 for
+ * backlight. Without any, only the read commands in ioctl_reads[] are
+ * accepted.
+ */
+static ushort ioctl_writes[16];
+static int ioctl_writes_num;
+module_param_array(ioctl_writes, ushort, &ioctl_writes_num, 0444);
+MODULE_PARM_DESC(ioctl_writes,
+		 "PMC write commands allowed through /dev/eiois200.\n");
+
+/**
+ * pmc_irq: IRQ number per chip used to signal PMC output buffer full.
+ * With an IRQ the core sleeps on a completion instead of polling the
+ * status port for every byte read. 0 keeps the polling mode.
+ */
+static int pmc_irq[EIOIS200_EC_NUM];
+module_param_array(pmc_irq, int, NULL, 0444);
+MODULE_PARM_DESC(pmc_irq,
+		 "PMC OBF IRQ number for main,sub chip. 0 for polling mode.\n");
+
+/**
+ * cache: Serve PMC reads with a non-zero pmc_op.ttl from memory until the
+ * ttl expires. A write to the same command, control and device id drops
+ * the cached value.
+ */
+static bool cache = true;
+module_param(cache, bool, 0644);
+MODULE_PARM_DESC(cache, "Enable the PMC read cache.\n");
+
+/**
+ * snapshot_ms: Sampling interval of the sensor snapshot table read by
+ * eiois200_core_snapshot(). A channel is dropped from the sampling after
+ * SNAP_IDLE intervals without a reader. 0 reads every value live.
+ */
+static uint snapshot_ms = DEFAULT_SNAPSHOT;
+module_param(snapshot_ms, uint, 0644);
+MODULE_PARM_DESC(snapshot_ms,
+		 "Sensor snapshot sampling interval in msec, 0 to disable.\n");
+
+/**
+ * save_ms: Quiet period in milliseconds after the last persistent write
+ * before the core saves the configuration to the EC flash with
+ * EIOIS200_PMC_CMD_CFG_SAVE. Each new persistent write restarts it, so a
+ * burst of tuning writes costs one flash commit. 0 saves after each write.
+ */
+static uint save_ms = DEFAULT_SAVE;
+module_param(save_ms, uint, 0644);
+MODULE_PARM_DESC(save_ms,
+		 "Configuration save delay after the last write in msec.\n");
+
+/**
+ * client_rate: Optional PMC transactions per second for each client in
+ * &enum eiois200_client order: core, hwmon, thermal, fan, gpio, pnp, wdt,
+ * bl, chardev. Bursts of one second worth are allowed, each command of a
+ * batch counts. A client over its limit gets -EBUSY instead of queueing,
+ * so a tight hwmon read loop cannot starve the watchdog or fan control.
+ * 0 for no limit.
+ */
+static uint client_rate[EIOIS200_CLIENT_NUM];
+module_param_array(client_rate, uint, NULL, 0644);
+MODULE_PARM_DESC(client_rate,
+		 "PMC transactions/s per client, 0 for no limit.\n");
+
+/**
+ * coalesce: A single read submitted while an identical one (command,
+ * control, device id and size) is still queued at the same priority waits
+ * for it and gets a copy of its payload. The queued read has not started
+ * yet, so the result is never older than the request.
+ */
+static bool coalesce = true;
+module_param(coalesce, bool, 0644);
+MODULE_PARM_DESC(coalesce, "Join identical queued PMC reads.\n");
+
+/**
+ * fast_io: Access the PMC data and command/status ports with ioread8() and
+ * iowrite8() instead of going through the regmap. The regmap is always
+ * used for the PNP configuration space.
+ */
+static bool fast_io = true;
+module_param(fast_io, bool, 0444);
+MODULE_PARM_DESC(fast_io, "Direct port I/O for PMC data/status ports.\n");
+
+struct eiois200_dev_port {
+	u16 idx_port;
+	u16 data_port;
+};
+
+static struct eiois200_dev_port pnp_port[] = {
+	{ .idx_port = EIOIS200_PNP_INDEX,     .data_port = EIOIS200_PNP_DATA     },
+	{ .idx_port = EIOIS200_SUB_PNP_INDEX, .data_port = EIOIS200_SUB_PNP_DATA },
+};
+
+static struct eiois200_dev *eiois200_dev;
+static struct regmap *regmap_is200;
+
+enum {
+	PMC_IO_DATA,
+	PMC_IO_CMD,
+	PMC_IO_NUM,
+};
+
+static struct pmc_chip {
+	struct device *dev;
+	int irq;
+
+	/*
+	 * Learned EC response time, updated by every successful OBF wait.
+	 * srtt is the average in usec << 3, rttvar the deviation << 2.
+	 */
+	u32 srtt;
+	u32 rttvar;
+	u32 spin_us;
+	u32 poll_us;
+	u32 timeout_us;
+
+	bool fast_io;
+	void __iomem *io[PMC_IO_NUM]; /* Data and command/status ports */
+	struct completion obf; /* Completed by pmc_isr() on OBF */
+
+	spinlock_t lock; /* Protects queue, qstat and bstat */
+	struct list_head queue[PMC_PRIO_NUM];
+	struct work_struct work;
+	struct workqueue_struct *wq;
+
+	/* Health, only changed from the chip worker */
+	bool failed;
+	uint fails;
+	u64 fast_fail; /* Protected by lock */
+	u64 trips;
+	struct delayed_work recover;
+	struct ratelimit_state rs;
+
+	struct {
+		u64 count;
+		u64 used_us;
+		u64 used_max_us;
+		u64 expired;
+	} bstat; /* Transaction budget, protected by lock */
+
+	struct {
+		u32 depth;
+		u32 depth_max;
+		u64 count;
+		u64 wait_ns;
+		u64 wait_max_ns;
+		u64 coalesced;
+	} qstat[PMC_PRIO_NUM];
+} pmc_chip[EIOIS200_EC_NUM];
+
+/* Order in which the chip worker serves the priority queues */
+static const u8 prio_order[] = {
+	PMC_PRIO_CRITICAL,
+	PMC_PRIO_INTERACTIVE,
+	PMC_PRIO_BACKGROUND,
+};
+
+static const char * const prio_name[PMC_PRIO_NUM] = {
+	[PMC_PRIO_INTERACTIVE]	= "interactive",
+	[PMC_PRIO_CRITICAL]	= "critical",
+	[PMC_PRIO_BACKGROUND]	= "background",
+};
+
+static struct dentry *debugfs_dir;
+
+/*
+ * Lockless PMC statistics. Histogram bucket n counts latencies below
+ * 2^n usec, the last bucket everything longer.
+ */
+struct pmc_hist {
+	atomic_t bucket[HIST_NUM];
+};
+
+static struct pmc_stat {
+	struct pmc_cmd_stat {
+		atomic64_t count;
+		atomic64_t bytes;
+		atomic64_t timeout;
+		atomic64_t error;
+		atomic64_t lock_ns;
+		struct pmc_hist xfer;
+	} cmd[CMD_NUM];
+
+	struct pmc_hist wait;
+} pmc_stat[EIOIS200_EC_NUM];
+
+struct pmc_cache_entry {
+	struct hlist_node node;
+	u32 key;
+	unsigned long expires;
+	u8 size;
+	u8 data[];
+};
+
+static DEFINE_HASHTABLE(pmc_cache, CACHE_BITS);
+static DEFINE_SPINLOCK(pmc_cache_lock); /* Protects pmc_cache and cstat */
+
+static struct {
+	u32 num;
+	u64 hit;
+	u64 miss;
+	u64 invalidate;
+} cstat;
+
+static const struct eiois200_pdata cell_pdata[EIOIS200_EC_NUM] = {
+	{ .chip = 0 },
+	{ .chip = 1 },
+};
+
+#define EIOIS200_CELL(_name, _chip) {			\
+	.name	       = _name,				\
+	.platform_data = &cell_pdata[_chip],		\
+	.pdata_size    = sizeof(struct eiois200_pdata),	\
+}
+
+#define EIOIS200_CELLS(chip) {				\
+	EIOIS200_CELL("eiois200_wdt",	  chip),	\
+	EIOIS200_CELL("gpio_eiois200",	  chip),	\
+	EIOIS200_CELL("eiois200_hwmon",	  chip),	\
+	EIOIS200_CELL("i2c_eiois200",	  chip),	\
+	EIOIS200_CELL("eiois200_thermal", chip),	\
+	EIOIS200_CELL("eiois200_fan",	  chip),	\
+	EIOIS200_CELL("eiois200_bl",	  chip),	\
+}
+
+#define CELL_NUM		7
+
+/* One set of child devices per EC */
+static const struct mfd_cell mfd_devs[EIOIS200_EC_NUM][CELL_NUM] = {
+	EIOIS200_CELLS(0),
+	EIOIS200_CELLS(1),
+};
+
+static struct regmap_range is200_range[] = {
+	 regmap_reg_range(EIOIS200_PNP_INDEX,	  EIOIS200_PNP_DATA),
+	 regmap_reg_range(EIOIS200_SUB_PNP_INDEX, EIOIS200_SUB_PNP_DATA),
+	 regmap_reg_range(0x200,		  0x3FF),
+};
+
+static const struct regmap_access_table volatile_regs = {
+	.yes_ranges   = is200_range,
+	.n_yes_ranges = ARRAY_SIZE(is200_range),
+};
+
+#if KERNEL_VERSION(6, 0, 0) <= LINUX_VERSION_CODE
+static const struct regmap_config pnp_regmap_config = {
+	.name		= "eiois200_core",
+	.reg_bits	= 16,
+	.val_bits	= 8,
+	.volatile_table = &volatile_regs,
+	.io_port	= true,
+	.cache_type	= REGCACHE_NONE,
+};
+#elif KERNEL_VERSION(5, 19, 0) <= LINUX_VERSION_CODE
+
+static int read(void *context, const void *reg_buf, size_t reg_size,
+		void *val_buf, size_t val_size)
+{
+	u16 *port = (u16 *)reg_buf;
+	u8 *val = (u8 *)val_buf;
+
+	*val = inb(*port);
+
+	return 0;
+}
+
+static int write(void *context, const void *data, size_t count)
+{
+	struct {
+		u16 reg : 16;
+		u8 val : 8;
+	} *p = (void *)data;
+
+	outb(p->val, p->reg);
+	return 0;
+}
+
+static int reg_read(void *context, unsigned int reg, unsigned int *val)
+{
+	*(u8 *)val = inb(reg);
+	return 0;
+}
+
+static int reg_write(void *context, unsigned int reg, unsigned int val)
+{
+	outb(val, reg);
+	return 0;
+}
+
+static const struct regmap_config pnp_regmap_config = {
+	.name		= "eiois200_core",
+	.reg_bits	= 16,
+	.val_bits	= 8,
+	.volatile_table = &volatile_regs,
+	.read		= read,
+	.write		= write,
+	.reg_read	= reg_read,
+	.reg_write	= reg_write,
+};
+#else
+//#elif LINUX_VERSION_CODE >= KERNEL_VERSION(5, 10, 0)
+static int reg_read(void *context, unsigned int reg, unsigned int *val)
+{
+	*val = (uint)inb(reg);
+	return 0;
+}
+
+static int reg_write(void *context, unsigned int reg, unsigned int val)
+{
+	outb(val, reg);
+	return 0;
+}
+
+static const struct regmap_config pnp_regmap_config = {
+	.name		= "eiois200_core",
+	.reg_bits	= 16,
+	.val_bits	= 8,
+	.volatile_table = &volatile_regs,
+	.reg_read	= reg_read,
+	.reg_write	= reg_write,
+	.fast_io	= true,
+};
+
+//#else
+//	#error "Unsupported kernel version! This driver requires at least Linux kernel 5.10.0"
+#endif
+
+enum {
+	INFO_BOARD_NAME,
+	INFO_BOARD_SERIAL,
+	INFO_BOARD_MANUFACTURER,
+	INFO_BOARD_ID,
+	INFO_FIRMWARE_VERSION,
+	INFO_FIRMWARE_NAME,
+	INFO_FIRMWARE_BUILD,
+	INFO_FIRMWARE_DATE,
+	INFO_CHIP_ID,
+	INFO_CHIP_DETECT,
+	INFO_PLATFORM_TYPE,
+	INFO_PLATFORM_REVISION,
+	INFO_EAPI_VERSION,
+	INFO_EAPI_ID,
+	INFO_BOOT_COUNT,
+	INFO_POWERUP_HOUR,
+	INFO_PNP_ID,
+	INFO_NUM,
+};
+
+/*
+ * Board information. Static entries are read once in eiois200_probe() and
+ * served from value[], dynamic ones are read on every access.
+ */
+static struct {
+	int  cmd;
+	int  ctrl;
+	int  dev;
+	int  size;
+	enum {
+		HEX,
+		NUMBER,
+		PNP_ID,
+	} type;
+	bool dynamic;
+
+	bool valid;
+	char value[32];
+} attrs[INFO_NUM] = {
+	[INFO_BOARD_NAME]	  = { 0x53, 0x10,    0, 16 },
+	[INFO_BOARD_SERIAL]	  = { 0x53, 0x1F,    0, 16 },
+	[INFO_BOARD_MANUFACTURER] = { 0x53, 0x11,    0, 16 },
+	[INFO_BOARD_ID]		  = { 0x53, 0x1E,    0,  4 },
+	[INFO_FIRMWARE_VERSION]	  = { 0x53, 0x21,    0,  4 },
+	[INFO_FIRMWARE_NAME]	  = { 0x53, 0x22,    0, 16 },
+	[INFO_FIRMWARE_BUILD]	  = { 0x53, 0x23,    0, 26 },
+	[INFO_FIRMWARE_DATE]	  = { 0x53, 0x24,    0, 16 },
+	[INFO_CHIP_ID]		  = { 0x53, 0x12,    0, 12 },
+	[INFO_CHIP_DETECT]	  = { 0x53, 0x15,    0, 12 },
+	[INFO_PLATFORM_TYPE]	  = { 0x53, 0x13,    0, 16 },
+#if 0
+	[INFO_PLATFORM_REVISION]  = { 0x53, 0x14,    0,  4 },
+#else
+	[INFO_PLATFORM_REVISION]  = { 0x53, 0x04, 0x44,  4 },
+#endif
+
+#if 0
+	[INFO_EAPI_VERSION]	  = { 0x53, 0x30,    0,  4 },
+#else
+	[INFO_EAPI_VERSION]	  = { 0x53, 0x04, 0x64,  4 },
+#endif
+	[INFO_EAPI_ID]		  = { 0x53, 0x31,    0,  4 },
+	[INFO_BOOT_COUNT]	  = { 0x55, 0x10,    0,  4, NUMBER, true },
+	[INFO_POWERUP_HOUR]	  = { 0x55, 0x11,    0,  4, NUMBER, true },
+	[INFO_PNP_ID]		  = { 0x53, 0x04, 0x68,  4, PNP_ID },
+};
+
+void __iomem *iomem;
+
+/* Default per-byte timeout of a chip */
+static uint pmc_timeout(int id)
+{
+	return timeout ? timeout : READ_ONCE(pmc_chip[id].timeout_us);
+}
+
+struct info_attribute {
+	struct device_attribute attr;
+	int idx;
+};
+
+#define to_info_attr(_attr) container_of(_attr, struct info_attribute, attr)
+
+static ssize_t info_show(struct device *dev,
+			 struct device_attribute *attr, char *buf)
+{
+	int  i = to_info_attr(attr)->idx;
+	char str[32] = "";
+	int  val;
+
+	if (attrs[i].valid) {
+		memcpy(str, attrs[i].value, sizeof(str));
+	} else {
+		int ret;
+		struct pmc_op op = {
+			.cmd	   = attrs[i].cmd,
+			.control   = attrs[i].ctrl,
+			.device_id = attrs[i].dev,
+			.payload   = (u8 *)str,
+			.size	   = attrs[i].size,
+		};
+
+		ret = eiois200_core_pmc_operation(dev, &op);
+		if (ret)
+			return ret;
+	}
+
+	if (attrs[i].size != 4)
+		return sprintf(buf, "%s\n", str);
+
+	val = *(u32 *)str;
+
+	if (attrs[i].type == HEX)
+		return sprintf(buf, "0x%08X\n", val);
+
+	if (attrs[i].type == NUMBER)
+		return sprintf(buf, "%d\n", val);
+
+	/* Should be pnp_id */
+	return sprintf(buf, "%c%c%c, %X\n",
+		       (val >> 14 & 0x3F) + 0x40,
+		       ((val >> 9 & 0x18) | (val >> 25 & 0x07)) + 0x40,
+		       (val >> 20 & 0x1F) + 0x40,
+		       val & 0xFFF);
+}
+
+/**
+ * info_init - Read all static board information in one batch
+ * @dev:	The device structure pointer.
+ *
+ * Entries that fail here are retried by info_show() on access.
+ */
+static void info_init(struct device *dev)
+{
+	struct pmc_op ops[INFO_NUM];
+	int status[INFO_NUM];
+	int idx[INFO_NUM];
+	uint i, num = 0;
+
+	for (i = 0; i < INFO_NUM; i++) {
+		if (attrs[i].dynamic)
+			continue;
+
+		ops[num] = (struct pmc_op) {
+			.cmd	   = attrs[i].cmd,
+			.control   = attrs[i].ctrl,
+			.device_id = attrs[i].dev,
+			.payload   = (u8 *)attrs[i].value,
+			.size	   = attrs[i].size,
+			.priority  = PMC_PRIO_BACKGROUND,
+		};
+		idx[num++] = i;
+	}
+
+	eiois200_core_pmc_batch(dev, ops, num, status);
+
+	for (i = 0; i < num; i++)
+		attrs[idx[i]].valid = status[i] == 0;
+}
+
+#define PMC_DEVICE_ATTR_RO(_name, _idx) \
+static struct info_attribute dev_attr_##_name = { \
+	.attr = __ATTR(_name, 0444, info_show, NULL), \
+	.idx  = _idx, \
+}
+
+PMC_DEVICE_ATTR_RO(board_name,		INFO_BOARD_NAME);
+PMC_DEVICE_ATTR_RO(board_serial,	INFO_BOARD_SERIAL);
+PMC_DEVICE_ATTR_RO(board_manufacturer,	INFO_BOARD_MANUFACTURER);
+PMC_DEVICE_ATTR_RO(firmware_name,	INFO_FIRMWARE_NAME);
+PMC_DEVICE_ATTR_RO(firmware_version,	INFO_FIRMWARE_VERSION);
+PMC_DEVICE_ATTR_RO(firmware_build,	INFO_FIRMWARE_BUILD);
+PMC_DEVICE_ATTR_RO(firmware_date,	INFO_FIRMWARE_DATE);
+PMC_DEVICE_ATTR_RO(chip_id,		INFO_CHIP_ID);
+PMC_DEVICE_ATTR_RO(chip_detect,		INFO_CHIP_DETECT);
+PMC_DEVICE_ATTR_RO(platform_type,	INFO_PLATFORM_TYPE);
+PMC_DEVICE_ATTR_RO(platform_revision,	INFO_PLATFORM_REVISION);
+PMC_DEVICE_ATTR_RO(board_id,		INFO_BOARD_ID);
+PMC_DEVICE_ATTR_RO(eapi_version,	INFO_EAPI_VERSION);
+PMC_DEVICE_ATTR_RO(eapi_id,		INFO_EAPI_ID);
+PMC_DEVICE_ATTR_RO(boot_count,		INFO_BOOT_COUNT);
+PMC_DEVICE_ATTR_RO(powerup_hour,	INFO_POWERUP_HOUR);
+PMC_DEVICE_ATTR_RO(pnp_id,		INFO_PNP_ID);
+
+/* Deferred configuration save state, see pmc_save_update() */
+static void pmc_save_work(struct work_struct *work);
+
+static struct {
+	unsigned long dirty; /* Bit per chip with unsaved persistent writes */
+	struct mutex lock; /* Serializes the saves */
+	struct delayed_work work;
+	struct device *dev;
+	atomic64_t marked;
+	atomic64_t saved;
+	atomic64_t failed;
+} cfg_save = {
+	.lock = __MUTEX_INITIALIZER(cfg_save.lock),
+	.work = __DELAYED_WORK_INITIALIZER(cfg_save.work, pmc_save_work, 0),
+};
+
+/* Reads 1 while persistent settings wait to be saved, any write saves them */
+static ssize_t cfg_sync_show(struct device *dev,
+			     struct device_attribute *attr, char *buf)
+{
+	return sysfs_emit(buf, "%d\n", READ_ONCE(cfg_save.dirty) ? 1 : 0);
+}
+
+static ssize_t cfg_sync_store(struct device *dev,
+			      struct device_attribute *attr,
+			      const char *buf, size_t count)
+{
+	int ret = eiois200_core_cfg_sync(dev);
+
+	return ret ? ret : count;
+}
+static DEVICE_ATTR_RW(cfg_sync);
+
+static struct attribute *pmc_attrs[] = {
+	&dev_attr_board_name.attr.attr,
+	&dev_attr_board_serial.attr.attr,
+	&dev_attr_board_manufacturer.attr.attr,
+	&dev_attr_firmware_name.attr.attr,
+	&dev_attr_firmware_version.attr.attr,
+	&dev_attr_firmware_build.attr.attr,
+	&dev_attr_firmware_date.attr.attr,
+	&dev_attr_chip_id.attr.attr,
+	&dev_attr_chip_detect.attr.attr,
+	&dev_attr_platform_type.attr.attr,
+	&dev_attr_platform_revision.attr.attr,
+	&dev_attr_board_id.attr.attr,
+	&dev_attr_eapi_version.attr.attr,
+	&dev_attr_eapi_id.attr.attr,
+	&dev_attr_boot_count.attr.attr,
+	&dev_attr_powerup_hour.attr.attr,
+	&dev_attr_pnp_id.attr.attr,
+	&dev_attr_cfg_sync.attr,
+	NULL
+};
+
+static const struct attribute_group pmc_group = {
+	.attrs = pmc_attrs,
+};
+
+/* Learned EC timing of each chip, see pmc_learn_update() */
+enum {
+	LEARN_LATENCY,
+	LEARN_DEVIATION,
+	LEARN_POLL,
+	LEARN_TIMEOUT,
+};
+
+struct learn_attribute {
+	struct device_attribute attr;
+	int chip;
+	int item;
+};
+
+#define to_learn_attr(_attr) container_of(_attr, struct learn_attribute, attr)
+
+static ssize_t learn_show(struct device *dev,
+			  struct device_attribute *attr, char *buf)
+{
+	struct learn_attribute *la = to_learn_attr(attr);
+	struct pmc_chip *chip = &pmc_chip[la->chip];
+	u32 val;
+
+	switch (la->item) {
+	case LEARN_LATENCY:
+		val = READ_ONCE(chip->srtt) >> 3;
+		break;
+	case LEARN_DEVIATION:
+		val = READ_ONCE(chip->rttvar) >> 2;
+		break;
+	case LEARN_POLL:
+		val = READ_ONCE(chip->poll_us);
+		break;
+	default:
+		val = pmc_timeout(la->chip);
+		break;
+	}
+
+	return sysfs_emit(buf, "%u\n", val);
+}
+
+#define PMC_LEARN_ATTR_RO(_chip, _name, _item) \
+static struct learn_attribute dev_attr_pmc##_chip##_##_name = { \
+	.attr = __ATTR(pmc##_chip##_##_name, 0444, learn_show, NULL), \
+	.chip = _chip, \
+	.item = _item, \
+}
+
+PMC_LEARN_ATTR_RO(0, latency_us,	LEARN_LATENCY);
+PMC_LEARN_ATTR_RO(0, deviation_us,	LEARN_DEVIATION);
+PMC_LEARN_ATTR_RO(0, poll_us,		LEARN_POLL);
+PMC_LEARN_ATTR_RO(0, timeout_us,	LEARN_TIMEOUT);
+PMC_LEARN_ATTR_RO(1, latency_us,	LEARN_LATENCY);
+PMC_LEARN_ATTR_RO(1, deviation_us,	LEARN_DEVIATION);
+PMC_LEARN_ATTR_RO(1, poll_us,		LEARN_POLL);
+PMC_LEARN_ATTR_RO(1, timeout_us,	LEARN_TIMEOUT);
+
+static struct attribute *learn_attrs[] = {
+	&dev_attr_pmc0_latency_us.attr.attr,
+	&dev_attr_pmc0_deviation_us.attr.attr,
+	&dev_attr_pmc0_poll_us.attr.attr,
+	&dev_attr_pmc0_timeout_us.attr.attr,
+	&dev_attr_pmc1_latency_us.attr.attr,
+	&dev_attr_pmc1_deviation_us.attr.attr,
+	&dev_attr_pmc1_poll_us.attr.attr,
+	&dev_attr_pmc1_timeout_us.attr.attr,
+	NULL
+};
+
+static umode_t learn_is_visible(struct kobject *kobj,
+				struct attribute *attr, int n)
+{
+	struct device_attribute *dattr =
+		container_of(attr, struct device_attribute, attr);
+
+	return eiois200_chip_exist(eiois200_dev, to_learn_attr(dattr)->chip) ?
+	       attr->mode : 0;
+}
+
+static const struct attribute_group learn_group = {
+	.attrs	    = learn_attrs,
+	.is_visible = learn_is_visible,
+};
+
+static const struct attribute_group *pmc_groups[] = {
+	&pmc_group,
+	&learn_group,
+	NULL
+};
+
+/* Following are the per client accounting functions */
+static const char * const client_name[EIOIS200_CLIENT_NUM] = {
+	[EIOIS200_CLIENT_CORE]	  = "core",
+	[EIOIS200_CLIENT_HWMON]	  = "hwmon",
+	[EIOIS200_CLIENT_THERMAL] = "thermal",
+	[EIOIS200_CLIENT_FAN]	  = "fan",
+	[EIOIS200_CLIENT_GPIO]	  = "gpio",
+	[EIOIS200_CLIENT_PNP]	  = "pnp",
+	[EIOIS200_CLIENT_WDT]	  = "wdt",
+	[EIOIS200_CLIENT_BL]	  = "bl",
+	[EIOIS200_CLIENT_CHARDEV] = "chardev",
+};
+
+static DEFINE_SPINLOCK(client_lock); /* Protects the token buckets */
+
+static struct pmc_client {
+	/* Token bucket, in transactions scaled by NSEC_PER_SEC */
+	uint rate;
+	u64 tokens;
+	ktime_t stamp;
+
+	atomic64_t count;
+	atomic64_t bytes;
+	atomic64_t busy_ns;
+	atomic64_t throttled;
+} pmc_client[EIOIS200_CLIENT_NUM];
+
+/**
+ * pmc_client_admit - Take tokens for new transactions of a client
+ * @client:	One of &enum eiois200_client.
+ * @num:	Number of transactions.
+ *
+ * The bucket holds up to one second of client_rate and refills
+ * continuously. It starts full and again whenever the rate is changed.
+ * Each transaction of a batch costs a token, so a batch larger than
+ * client_rate can never be admitted.
+ * Returns:	0, -EBUSY if the client is over its limit.
+ */
+static int pmc_client_admit(u8 client, uint num)
+{
+	struct pmc_client *c;
+	u64 cap, cost;
+	ktime_t now;
+	s64 elapsed;
+	uint rate;
+	int ret = 0;
+
+	if (client >= EIOIS200_CLIENT_NUM)
+		return -EINVAL;
+
+	rate = READ_ONCE(client_rate[client]);
+	if (!rate)
+		return 0;
+
+	c    = &pmc_client[client];
+	cap  = (u64)rate * NSEC_PER_SEC;
+	cost = (u64)num * NSEC_PER_SEC;
+
+	spin_lock(&client_lock);
+
+	now = ktime_get();
+	if (c->rate != rate) {
+		c->rate   = rate;
+		c->tokens = cap;
+		c->stamp  = now;
+	}
+
+	elapsed = min_t(s64, ktime_to_ns(ktime_sub(now, c->stamp)),
+			NSEC_PER_SEC);
+	c->tokens = min(c->tokens + (u64)elapsed * rate, cap);
+	c->stamp  = now;
+
+	if (c->tokens >= cost)
+		c->tokens -= cost;
+	else
+		ret = -EBUSY;
+
+	spin_unlock(&client_lock);
+
+	if (ret)
+		atomic64_inc(&c->throttled);
+
+	return ret;
+}
+
+static void pmc_client_account(u8 client, uint num, uint bytes, s64 busy_ns)
+{
+	struct pmc_client *c;
+
+	if (client >= EIOIS200_CLIENT_NUM)
+		return;
+
+	c = &pmc_client[client];
+	atomic64_add(num, &c->count);
+	atomic64_add(bytes, &c->bytes);
+	atomic64_add(busy_ns, &c->busy_ns);
+}
+
+/* Following are EIO-IS200 PNP IO port access functions */
+static int is200_pnp_read(struct eiois200_dev_port *port, u8 idx, u8 *val)
+{
+	uint data;
+
+	if (regmap_write(regmap_is200, port->idx_port, idx) ||
+	    regmap_read(regmap_is200, port->data_port, &data))
+		return -EIO;
+
+	*val = data;
+
+	return 0;
+}
+
+static int is200_pnp_write(struct eiois200_dev_port *port, u8 idx, u8 data)
+{
+	if (regmap_write(regmap_is200, port->idx_port, idx) ||
+	    regmap_write(regmap_is200, port->data_port, data))
+		return -EIO;
+
+	return 0;
+}
+
+static int is200_pnp_enter(struct eiois200_dev_port *port)
+{
+	/* Write 0x87 to index port twice to unlock IO port */
+	if (regmap_write(regmap_is200, port->idx_port, EIOIS200_EXT_MODE_ENTER) ||
+	    regmap_write(regmap_is200, port->idx_port, EIOIS200_EXT_MODE_ENTER))
+		return -EIO;
+
+	return 0;
+}
+
+static int is200_pnp_leave(struct eiois200_dev_port *port)
+{
+	/* Write 0xAA to index port once to lock IO port */
+	if (regmap_write(regmap_is200, port->idx_port, EIOIS200_EXT_MODE_EXIT))
+		return -EIO;
+
+	return 0;
+}
+
+/*
+ * PNP configuration cache
+ *
+ * The logical device registers that drivers discover with, activation,
+ * I/O bases and IRQ, are kept after the first access. Nothing but this
+ * driver changes them, so a read that hits does not enter the
+ * configuration space at all. Writes always go to the hardware and then
+ * update the cache. Protected by eiois200_dev->mutex.
+ */
+#define PNP_GLOBAL_END	0x30	/* Registers below are not per logical device */
+
+static const u8 pnp_cached_regs[] = {
+	EIOIS200_LDAR,
+	EIOIS200_IOBA0H, EIOIS200_IOBA0L,
+	EIOIS200_IOBA1H, EIOIS200_IOBA1L,
+	EIOIS200_IRQCTRL,
+};
+
+static struct {
+	u8 val[256][ARRAY_SIZE(pnp_cached_regs)];
+	u8 valid[256];	/* Bitmap of val[ldn][] */
+	u64 hit;
+	u64 enter;
+} pnp_cache[EIOIS200_EC_NUM];
+
+static int pnp_slot(u8 reg)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(pnp_cached_regs); i++)
+		if (pnp_cached_regs[i] == reg)
+			return i;
+
+	return -1;
+}
+
+static bool pnp_cache_get(int chip, struct pnp_op *op)
+{
+	int slot = pnp_slot(op->reg);
+
+	if (op->write || slot < 0 || !(pnp_cache[chip].valid[op->ldn] & BIT(slot)))
+		return false;
+
+	op->val = pnp_cache[chip].val[op->ldn][slot];
+
+	return true;
+}
+
+static void pnp_cache_put(int chip, const struct pnp_op *op)
+{
+	int slot = pnp_slot(op->reg);
+
+	if (slot < 0)
+		return;
+
+	pnp_cache[chip].val[op->ldn][slot] = op->val;
+	pnp_cache[chip].valid[op->ldn] |= BIT(slot);
+}
+
+/**
+ * pnp_batch - Run PNP configuration accesses in one configuration entry
+ * @dev:	The device structure pointer.
+ * @chip:	0 for main chip, 1 for sub chip.
+ * @ops:	Accesses, in order. Reads return their value in &pnp_op.val.
+ * @num:	Number of accesses in @ops.
+ *
+ * Cached reads are served without touching the ports. The configuration
+ * space is entered at the first access that needs the hardware and left
+ * once at the end, the LDN is only selected when it changes.
+ */
+static int pnp_batch(struct device *dev, int chip, struct pnp_op *ops, uint num)
+{
+	struct eiois200_dev_port *port = &pnp_port[chip];
+	bool entered = false;
+	int ldn = -1;
+	int ret = 0;
+	uint i;
+
+	mutex_lock(&eiois200_dev->mutex);
+
+	for (i = 0; i < num && !ret; i++) {
+		struct pnp_op *op = &ops[i];
+
+		if (pnp_cache_get(chip, op)) {
+			pnp_cache[chip].hit++;
+			continue;
+		}
+
+		if (!entered) {
+			entered = true;
+			pnp_cache[chip].enter++;
+			ret = is200_pnp_enter(port);
+			if (ret)
+				break;
+		}
+
+		if (op->reg >= PNP_GLOBAL_END && op->ldn != ldn) {
+			ret = is200_pnp_write(port, EIOIS200_LDN, op->ldn);
+			if (ret)
+				break;
+
+			ldn = op->ldn;
+		}
+
+		if (op->write)
+			ret = is200_pnp_write(port, op->reg, op->val);
+		else
+			ret = is200_pnp_read(port, op->reg, &op->val);
+
+		if (!ret && op->reg >= PNP_GLOBAL_END)
+			pnp_cache_put(chip, op);
+	}
+
+	if (entered && is200_pnp_leave(port) && !ret)
+		ret = -EIO;
+
+	mutex_unlock(&eiois200_dev->mutex);
+
+	if (ret)
+		dev_err(dev, "PNP%d port 0x%X access error\n", chip, port->idx_port);
+
+	return ret;
+}
+
+/**
+ * eiois200_core_pnp_batch - Access PNP configuration registers of an EC
+ * @dev:	The device structure pointer.
+ * @chip:	0 for main chip, 1 for sub chip.
+ * @ops:	Accesses, in order. Reads return their value in &pnp_op.val.
+ * @num:	Number of accesses in @ops.
+ */
+int eiois200_core_pnp_batch(struct device *dev, u8 chip,
+			    struct pnp_op *ops, uint num)
+{
+	ktime_t start;
+	int ret;
+
+	if (!eiois200_dev || !eiois200_chip_exist(eiois200_dev, chip))
+		return -ENODEV;
+
+	ret = pmc_client_admit(EIOIS200_CLIENT_PNP, num);
+	if (ret)
+		return ret;
+
+	start = ktime_get();
+	ret = pnp_batch(dev, chip, ops, num);
+	pmc_client_account(EIOIS200_CLIENT_PNP, num, num,
+			   ktime_to_ns(ktime_sub(ktime_get(), start)));
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(eiois200_core_pnp_batch);
+
+/* Following are EIO-IS200 IO port access functions for PMC command */
+
+/**
+ * struct pmc_budget - Deadline of one PMC transaction
+ * @start:	Time the transaction started.
+ * @deadline:	Time all waits of the transaction must end by.
+ * @timeout:	Per-byte wait limit in usec.
+ */
+struct pmc_budget {
+	ktime_t start;
+	ktime_t deadline;
+	uint	timeout;
+};
+
+static int pmc_wait(struct device *dev,
+		    int id,
+		    enum eiois200_pmc_wait wait,
+		    uint new_timeout);
+
+static void pmc_budget_init(struct pmc_budget *b, int id, u16 timeout)
+{
+	b->timeout  = timeout ? timeout : pmc_timeout(id);
+	b->start    = ktime_get();
+
+	/* Only an explicit pmc_op.timeout may stretch the deadline */
+	b->deadline = ktime_add_us(b->start, max_t(uint, budget, timeout));
+}
+
+/* Per-byte wait limit drawn from the rest of the budget, 0 if it ran out */
+static uint pmc_budget_left(struct pmc_budget *b)
+{
+	s64 left = ktime_us_delta(b->deadline, ktime_get());
+
+	if (left <= 0)
+		return 0;
+
+	return min_t(s64, left, b->timeout);
+}
+
+static void pmc_budget_account(int id, struct pmc_budget *b, int err)
+{
+	struct pmc_chip *chip = &pmc_chip[id];
+	u64 used = ktime_us_delta(ktime_get(), b->start);
+
+	spin_lock(&chip->lock);
+	chip->bstat.count++;
+	chip->bstat.used_us += used;
+	chip->bstat.used_max_us = max(chip->bstat.used_max_us, used);
+	if (err == -ETIME && ktime_after(ktime_get(), b->deadline))
+		chip->bstat.expired++;
+	spin_unlock(&chip->lock);
+}
+
+static u16 pmc_io_port(int id, int reg)
+{
+	return reg == PMC_IO_DATA ? eiois200_dev->pmc[id].data :
+				    eiois200_dev->pmc[id].cmd;
+}
+
+static int pmc_io_read(int id, int reg, uint *val)
+{
+	if (pmc_chip[id].fast_io) {
+		*val = ioread8(pmc_chip[id].io[reg]);
+		return 0;
+	}
+
+	return regmap_read(regmap_is200, pmc_io_port(id, reg), val);
+}
+
+static int pmc_io_write(int id, int reg, u8 val)
+{
+	if (pmc_chip[id].fast_io) {
+		iowrite8(val, pmc_chip[id].io[reg]);
+		return 0;
+	}
+
+	return regmap_write(regmap_is200, pmc_io_port(id, reg), val);
+}
+
+static int pmc_write_data(struct device *dev,
+			  int id,
+			  u8 value,
+			  struct pmc_budget *b)
+{
+	int ret;
+
+	if (pmc_wait(dev, id, PMC_WAIT_INPUT, pmc_budget_left(b)))
+		return -ETIME;
+
+	ret = pmc_io_write(id, PMC_IO_DATA, value);
+	if (ret)
+		dev_err(dev, "Error PMC write %X:%X\n",
+			eiois200_dev->pmc[id].data, value);
+
+	return ret;
+}
+
+static int pmc_write_cmd(struct device *dev,
+			 int id,
+			 u8 value,
+			 struct pmc_budget *b)
+{
+	int ret;
+
+	if (pmc_wait(dev, id, PMC_WAIT_INPUT, pmc_budget_left(b)))
+		return -ETIME;
+
+	ret = pmc_io_write(id, PMC_IO_CMD, value);
+	if (ret)
+		dev_err(dev, "Error PMC write %X:%X\n",
+			eiois200_dev->pmc[id].cmd, value);
+
+	return ret;
+}
+
+static int pmc_read_data(struct device *dev,
+			 int id,
+			 u8 *value,
+			 struct pmc_budget *b)
+{
+	uint val;
+	int ret;
+
+	if (pmc_wait(dev, id, PMC_WAIT_OUTPUT, pmc_budget_left(b)))
+		return -ETIME;
+
+	ret = pmc_io_read(id, PMC_IO_DATA, &val);
+	if (ret)
+		dev_err(dev, "Error PMC read %X\n",
+			eiois200_dev->pmc[id].data);
+	else
+		*value = val & 0xFF;
+
+	return ret;
+}
+
+/**
+ * pmc_read_status - Read the pmc current status
+ * @dev:	The device structure pointer.
+ * @id:		0 for main chip, 1 for sub chip.
+ * Returns:	The current status read from the PMC,
+ *		or 0 if there was an error.
+ */
+static int pmc_read_status(struct device *dev, int id)
+{
+	uint val;
+
+	if (pmc_io_read(id, PMC_IO_CMD, &val)) {
+		dev_err(dev, "Error PMC read %X\n", eiois200_dev->pmc[id].status);
+		return 0;
+	}
+
+	return val;
+}
+
+static void pmc_clear(struct device *dev, int id)
+{
+	uint val;
+
+	/* Check if input buffer blocked */
+	if ((pmc_read_status(dev, id) & EIOIS200_PMC_STATUS_IBF) == 0)
+		return;
+
+	/* Read out previous garbage */
+	if (pmc_io_read(id, PMC_IO_DATA, &val))
+		dev_err(dev, "Error pmc clear\n");
+
+	usleep_range(10, 100);
+}
+
+static irqreturn_t pmc_isr(int irq, void *arg)
+{
+	int id = (struct pmc_chip *)arg - pmc_chip;
+	uint val;
+
+	/* The line may be shared, only claim it if our OBF is set */
+	if (pmc_io_read(id, PMC_IO_CMD, &val) ||
+	    (val & EIOIS200_PMC_STATUS_OBF) == 0)
+		return IRQ_NONE;
+
+	complete(&pmc_chip[id].obf);
+
+	return IRQ_HANDLED;
+}
+
+/**
+ * pmc_wait_obf_irq - Sleep until the output buffer is full.
+ * @dev:		The device structure pointer.
+ * @id:			0 for main chip, 1 for sub chip.
+ * @max_duration:	The timeout value in usec.
+ *
+ * The status is re-checked after each wake up, so a spurious or a shared
+ * interrupt only costs one status read.
+ */
+static int pmc_wait_obf_irq(struct device *dev, int id, uint max_duration)
+{
+	struct pmc_chip *chip = &pmc_chip[id];
+	unsigned long end = jiffies + usecs_to_jiffies(max_duration) + 1;
+	long left;
+
+	for (;;) {
+		reinit_completion(&chip->obf);
+
+		if (pmc_read_status(dev, id) & EIOIS200_PMC_STATUS_OBF)
+			return 0;
+
+		left = (long)(end - jiffies);
+		if (left <= 0)
+			return -ETIMEDOUT;
+
+		wait_for_completion_timeout(&chip->obf, left);
+	}
+}
+
+/**
+ * pmc_learn_update - Track the EC response time of a chip
+ * @id:		0 for main chip, 1 for sub chip.
+ * @us:		Duration of a successful OBF wait in usec.
+ *
+ * Keeps a smoothed average and deviation like the TCP RTT estimator and
+ * derives the spin time, the first poll interval and the default timeout.
+ * The timeout stays between DEFAULT_TIMEOUT, the documented EC response
+ * time can be a few msec, and LEARN_MAX. Called with the PMC mutex of the
+ * chip held.
+ */
+static void pmc_learn_update(int id, u32 us)
+{
+	struct pmc_chip *chip = &pmc_chip[id];
+	s32 m = us;
+	u32 avg, var;
+
+	if (!chip->srtt) {
+		chip->srtt   = max(m, 1) << 3;
+		chip->rttvar = m << 1;
+	} else {
+		m -= chip->srtt >> 3;
+		chip->srtt += m;
+		if (m < 0)
+			m = -m;
+		m -= chip->rttvar >> 2;
+		chip->rttvar += m;
+	}
+
+	avg = chip->srtt >> 3;
+	var = chip->rttvar >> 2;
+
+	WRITE_ONCE(chip->spin_us, min_t(u32, avg / 2, SPIN_MAX));
+	WRITE_ONCE(chip->poll_us, clamp_t(u32, avg / 4, SLEEP_MIN, SLEEP_MAX));
+	WRITE_ONCE(chip->timeout_us, clamp_t(u32, 10 * (avg + 4 * var),
+					     DEFAULT_TIMEOUT, LEARN_MAX));
+}
+
+/**
+ * pmc_learn_backoff - Widen the learned timeout after a timeout
+ * @id:		0 for main chip, 1 for sub chip.
+ *
+ * Doubles the timeout like a TCP retransmission timeout, up to LEARN_MAX.
+ * The next EC answer derives it from the samples again. Called with the
+ * PMC mutex of the chip held.
+ */
+static void pmc_learn_backoff(int id)
+{
+	struct pmc_chip *chip = &pmc_chip[id];
+
+	WRITE_ONCE(chip->timeout_us, min_t(u32, chip->timeout_us << 1,
+					   LEARN_MAX));
+}
+
+static void pmc_learn_init(int id)
+{
+	struct pmc_chip *chip = &pmc_chip[id];
+
+	chip->srtt	 = 0;
+	chip->rttvar	 = 0;
+	chip->spin_us	 = 0;
+	chip->poll_us	 = SLEEP_MAX;
+	chip->timeout_us = DEFAULT_TIMEOUT;
+}
+
+/**
+ * pmc_poll - Poll the PMC status until a flag reaches the wanted state
+ * @id:		0 for main chip, 1 for sub chip.
+ * @mask:	Status flag to check.
+ * @set:	Wait for the flag to be set or cleared.
+ * @max_us:	The timeout value in usec.
+ *
+ * Spins for the learned spin time, then sleeps starting at the learned
+ * poll interval and doubling up to SLEEP_MAX.
+ */
+static int pmc_poll(int id, u8 mask, bool set, uint max_us)
+{
+	struct pmc_chip *chip = &pmc_chip[id];
+	ktime_t start = ktime_get();
+	ktime_t end = ktime_add_us(start, max_us);
+	uint sleep = READ_ONCE(chip->poll_us);
+	uint spin = READ_ONCE(chip->spin_us);
+	bool expired = false;
+	uint val;
+
+	for (;;) {
+		if (pmc_io_read(id, PMC_IO_CMD, &val))
+			return -EIO;
+
+		if (!!(val & mask) == set)
+			return 0;
+
+		/* Re-checked once after the deadline like read_poll_timeout() */
+		if (expired)
+			return -ETIMEDOUT;
+
+		expired = ktime_after(ktime_get(), end);
+
+		if (ktime_us_delta(ktime_get(), start) < spin) {
+			udelay(1);
+			continue;
+		}
+
+		usleep_range(sleep, sleep * 2);
+		sleep = min(sleep * 2, SLEEP_MAX);
+	}
+}
+
+static int __pmc_wait(struct device *dev,
+		      int id,
+		      enum eiois200_pmc_wait wait,
+		      uint new_timeout)
+{
+	if (!new_timeout)
+		return -ETIMEDOUT;
+
+	/* The EC only interrupts on OBF, input buffer is always polled */
+	if (wait == PMC_WAIT_OUTPUT && pmc_chip[id].irq > 0)
+		return pmc_wait_obf_irq(dev, id, new_timeout);
+
+	if (wait == PMC_WAIT_INPUT)
+		return pmc_poll(id, EIOIS200_PMC_STATUS_IBF, false, new_timeout);
+
+	return pmc_poll(id, EIOIS200_PMC_STATUS_OBF, true, new_timeout);
+}
+
+static void pmc_hist_add(struct pmc_hist *hist, s64 ns)
+{
+	u64 us = div_u64(ns, NSEC_PER_USEC);
+
+	atomic_inc(&hist->bucket[us ? min(ilog2(us) + 1, HIST_NUM - 1) : 0]);
+}
+
+/* Wait for the PMC buffer state, a zero new_timeout fails at once */
+static int pmc_wait(struct device *dev,
+		    int id,
+		    enum eiois200_pmc_wait wait,
+		    uint new_timeout)
+{
+	ktime_t start = ktime_get();
+	s64 ns;
+	int ret;
+
+	ret = __pmc_wait(dev, id, wait, new_timeout);
+
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	pmc_hist_add(&pmc_stat[id].wait, ns);
+
+	/*
+	 * IBF clears at once, only the EC answer tells its response time.
+	 * The recovery probes of a failed chip are expected to time out.
+	 */
+	if (!ret && wait == PMC_WAIT_OUTPUT)
+		pmc_learn_update(id, div_u64(ns, NSEC_PER_USEC));
+	else if (ret == -ETIMEDOUT && new_timeout &&
+		 !READ_ONCE(pmc_chip[id].failed))
+		pmc_learn_backoff(id);
+	trace_eiois200_pmc_wait(id, wait, new_timeout, ns, ret);
+
+	return ret;
+}
+
+/**
+ * eiois200_core_pmc_wait - Wait for input / output buffer to be ready.
+ * @dev:		The device structure pointer.
+ * @id:			0 for main chip, 1 for sub chip.
+ * @wait:		%PMC_WAIT_INPUT or %PMC_WAIT_OUTPUT.
+ *			%PMC_WAIT_INPUT for waiting input buffer data ready.
+ *			%PMC_WAIT_OUTPUT for waiting output buffer empty.
+ * max_duration:	The timeout value in usec.
+ */
+int eiois200_core_pmc_wait(struct device *dev,
+			   int id,
+			   enum eiois200_pmc_wait wait,
+			   uint max_duration)
+{
+	uint new_timeout = max_duration ? max_duration : pmc_timeout(id);
+
+	if (new_timeout < TIMEOUT_MIN || new_timeout > TIMEOUT_MAX) {
+		dev_err(dev,
+			"Error timeout value: %dus. Timeout value should between %d and %ld\n",
+			new_timeout, TIMEOUT_MIN, TIMEOUT_MAX);
+		return -ETIME;
+	}
+
+	return pmc_wait(dev, id, wait, new_timeout);
+}
+EXPORT_SYMBOL_GPL(eiois200_core_pmc_wait);
+
+/**
+ * pmc_transfer - Run one PMC command, the caller holds the chip lock
+ * @dev:	The device structure pointer.
+ * @op:		Pointer to an PMC command.
+ */
+static int pmc_transfer(struct device *dev, struct pmc_op *op)
+{
+	u8	i;
+	int	ret;
+	bool	read_cmd = op->cmd & EIOIS200_FLAG_PMC_READ;
+	struct pmc_budget b;
+
+	pmc_budget_init(&b, op->chip, op->timeout);
+
+	pmc_clear(dev, op->chip);
+
+	ret = pmc_write_cmd(dev, op->chip, op->cmd, &b);
+	if (ret)
+		goto err;
+
+	ret = pmc_write_data(dev, op->chip, op->control, &b);
+	if (ret)
+		goto err;
+
+	/* ACPI RAM reads have no device id, control is the offset */
+	if (op->cmd != EIOIS200_PMC_CMD_ACPIRAM_READ) {
+		ret = pmc_write_data(dev, op->chip, op->device_id, &b);
+		if (ret)
+			goto err;
+	}
+
+	ret = pmc_write_data(dev, op->chip, op->size, &b);
+	if (ret)
+		goto err;
+
+	for (i = 0; i < op->size; i++) {
+		if (read_cmd)
+			ret = pmc_read_data(dev, op->chip,
+					    &op->payload[i], &b);
+		else
+			ret = pmc_write_data(dev, op->chip,
+					     op->payload[i], &b);
+
+		if (ret)
+			goto err;
+	}
+
+	pmc_budget_account(op->chip, &b, 0);
+
+	return 0;
+
+err:
+	pmc_budget_account(op->chip, &b, ret);
+
+	/* A dead EC fails every command, keep the log readable */
+	if (!__ratelimit(&pmc_chip[op->chip].rs))
+		return ret;
+
+	dev_err(dev, "PMC error duration:%lldus of %lldus budget",
+		ktime_us_delta(ktime_get(), b.start),
+		ktime_us_delta(b.deadline, b.start));
+	dev_err(dev, ".cmd=0x%02X, .ctrl=0x%02X .id=0x%02X, .size=0x%02X .data=0x%02X%02X",
+		op->cmd, op->control, op->device_id, op->size,
+		op->size > 0 ? op->payload[0] : 0,
+		op->size > 1 ? op->payload[1] : 0);
+
+	return ret;
+}
+
+/* Following are the PMC read cache functions */
+static struct pmc_cache_entry *pmc_cache_find(u32 key)
+{
+	struct pmc_cache_entry *entry;
+
+	hash_for_each_possible(pmc_cache, entry, node, key)
+		if (entry->key == key)
+			return entry;
+
+	return NULL;
+}
+
+static void pmc_cache_drop(struct pmc_cache_entry *entry)
+{
+	hash_del(&entry->node);
+	cstat.num--;
+	kfree(entry);
+}
+
+/**
+ * pmc_cache_get - Serve a read command from the cache
+ * @op:		Pointer to an PMC command.
+ * Returns:	true if the payload is filled from the cache.
+ */
+static bool pmc_cache_get(struct pmc_op *op)
+{
+	struct pmc_cache_entry *entry;
+	bool hit = false;
+
+	if (!cache || !op->ttl || !(op->cmd & EIOIS200_FLAG_PMC_READ))
+		return false;
+
+	spin_lock(&pmc_cache_lock);
+
+	entry = pmc_cache_find(CACHE_KEY(op->chip, op->cmd,
+					 op->control, op->device_id));
+	if (entry && entry->size == op->size &&
+	    time_before(jiffies, entry->expires)) {
+		memcpy(op->payload, entry->data, op->size);
+		hit = true;
+	}
+
+	if (hit)
+		cstat.hit++;
+	else
+		cstat.miss++;
+
+	spin_unlock(&pmc_cache_lock);
+
+	return hit;
+}
+
+/**
+ * pmc_cache_update - Update the cache after a PMC command
+ * @op:		Pointer to an PMC command.
+ * @err:	The result of the command.
+ *
+ * A successful read with a ttl is stored. Any write, even a failed one,
+ * drops the value cached for its read counterpart.
+ */
+static void pmc_cache_update(struct pmc_op *op, int err)
+{
+	struct pmc_cache_entry *entry, *old;
+	bool read_cmd = op->cmd & EIOIS200_FLAG_PMC_READ;
+	u32 key = CACHE_KEY(op->chip, op->cmd | EIOIS200_FLAG_PMC_READ,
+			    op->control, op->device_id);
+
+	if (!read_cmd) {
+		spin_lock(&pmc_cache_lock);
+		old = pmc_cache_find(key);
+		if (old) {
+			pmc_cache_drop(old);
+			cstat.invalidate++;
+		}
+		spin_unlock(&pmc_cache_lock);
+		return;
+	}
+
+	if (err || !cache || !op->ttl)
+		return;
+
+	entry = kmalloc(struct_size(entry, data, op->size), GFP_KERNEL);
+	if (!entry)
+		return;
+
+	entry->key = key;
+	entry->size = op->size;
+	entry->expires = jiffies + msecs_to_jiffies(op->ttl);
+	memcpy(entry->data, op->payload, op->size);
+
+	spin_lock(&pmc_cache_lock);
+
+	old = pmc_cache_find(key);
+	if (old)
+		pmc_cache_drop(old);
+
+	if (cstat.num < CACHE_MAX) {
+		hash_add(pmc_cache, &entry->node, key);
+		cstat.num++;
+		entry = NULL;
+	}
+
+	spin_unlock(&pmc_cache_lock);
+
+	kfree(entry);
+}
+
+static void pmc_cache_release(void *data)
+{
+	struct pmc_cache_entry *entry;
+	struct hlist_node *tmp;
+	int bkt;
+
+	spin_lock(&pmc_cache_lock);
+	hash_for_each_safe(pmc_cache, bkt, tmp, entry, node)
+		pmc_cache_drop(entry);
+	spin_unlock(&pmc_cache_lock);
+}
+
+/* Following are the sensor snapshot functions */
+static const struct {
+	u8 cmd;
+	u8 ctrl;
+	u8 size;
+	char name[8];
+} snap_info[EIOIS200_SNAP_NUM] = {
+	[EIOIS200_SNAP_TEMP]	 = { 0x11, 0x10, 2, "temp" },
+	[EIOIS200_SNAP_VOLT]	 = { 0x13, 0x10, 2, "volt" },
+	[EIOIS200_SNAP_FAN_CTRL] = { 0x25, 0x02, 1, "fan_ctrl" },
+};
+
+static void pmc_snapshot_work(struct work_struct *work);
+
+struct snap_entry {
+	u16 val;
+	bool valid;
+	ktime_t stamp;
+};
+
+static struct {
+	seqlock_t lock; /* Protects ent */
+	struct snap_entry ent[EIOIS200_EC_NUM][EIOIS200_SNAP_NUM][EIOIS200_SNAP_CH];
+
+	unsigned long wanted[EIOIS200_EC_NUM][EIOIS200_SNAP_NUM];
+	unsigned long used[EIOIS200_EC_NUM][EIOIS200_SNAP_NUM][EIOIS200_SNAP_CH];
+	struct delayed_work work;
+
+	/* Only used by pmc_snapshot_work(), kept off its stack */
+	struct pmc_op ops[EIOIS200_SNAP_NUM * EIOIS200_SNAP_CH];
+	u16 vals[EIOIS200_SNAP_NUM * EIOIS200_SNAP_CH];
+
+	struct device *dev;
+	atomic64_t hit;
+	atomic64_t miss;
+} snap = {
+	.lock = __SEQLOCK_UNLOCKED(snap.lock),
+	.work = __DELAYED_WORK_INITIALIZER(snap.work, pmc_snapshot_work, 0),
+};
+
+static int snap_find(const struct pmc_op *op)
+{
+	int type;
+
+	if (op->chip >= EIOIS200_EC_NUM || op->device_id >= EIOIS200_SNAP_CH)
+		return -1;
+
+	for (type = 0; type < EIOIS200_SNAP_NUM; type++)
+		if (snap_info[type].cmd == (op->cmd | EIOIS200_FLAG_PMC_READ) &&
+		    snap_info[type].ctrl == op->control)
+			return type;
+
+	return -1;
+}
+
+/**
+ * pmc_snapshot_update - Update the snapshot table after a PMC command
+ * @op:		Pointer to an PMC command.
+ * @err:	The result of the command.
+ *
+ * Any successful read of a snapshot value refreshes it, whoever issued
+ * it. A write to the same control drops it.
+ */
+static void pmc_snapshot_update(struct pmc_op *op, int err)
+{
+	bool read_cmd = op->cmd & EIOIS200_FLAG_PMC_READ;
+	int type = snap_find(op);
+	u16 val = 0;
+
+	if (type < 0 || (read_cmd && (err || op->size != snap_info[type].size)))
+		return;
+
+	if (read_cmd)
+		memcpy(&val, op->payload, op->size);
+
+	write_seqlock(&snap.lock);
+	snap.ent[op->chip][type][op->device_id].val   = val;
+	snap.ent[op->chip][type][op->device_id].valid = read_cmd;
+	snap.ent[op->chip][type][op->device_id].stamp = ktime_get();
+	write_sequnlock(&snap.lock);
+}
+
+/*
+ * Sample all values asked for recently in one background batch per chip.
+ * A channel not read for SNAP_IDLE intervals is dropped, and the sampling
+ * stops with the last one.
+ */
+static void pmc_snapshot_work(struct work_struct *work)
+{
+	uint interval = READ_ONCE(snapshot_ms);
+	unsigned long idle = msecs_to_jiffies(interval * SNAP_IDLE);
+	int chip, type, ch, num, n;
+	bool wanted = false;
+
+	if (!interval)
+		return;
+
+	/* Results land through pmc_snapshot_update() */
+	for (chip = 0; chip < EIOIS200_EC_NUM; chip++) {
+		num = 0;
+
+		for (type = 0; type < EIOIS200_SNAP_NUM; type++)
+			for_each_set_bit(ch, &snap.wanted[chip][type],
+					 EIOIS200_SNAP_CH) {
+				if (time_after(jiffies,
+					       READ_ONCE(snap.used[chip][type][ch]) +
+					       idle)) {
+					clear_bit(ch, &snap.wanted[chip][type]);
+					continue;
+				}
+
+				n = num++;
+				snap.ops[n] = (struct pmc_op) {
+					.cmd	   = snap_info[type].cmd,
+					.control   = snap_info[type].ctrl,
+					.device_id = ch,
+					.size	   = snap_info[type].size,
+					.payload   = (u8 *)&snap.vals[n],
+					.chip	   = chip,
+					.priority  = PMC_PRIO_BACKGROUND,
+				};
+			}
+
+		if (num) {
+			eiois200_core_pmc_batch(snap.dev, snap.ops, num, NULL);
+			wanted = true;
+		}
+	}
+
+	if (wanted)
+		schedule_delayed_work(&snap.work, msecs_to_jiffies(interval));
+}
+
+/**
+ * eiois200_core_snapshot - Read a sensor value from the snapshot table
+ * @dev:	The device structure pointer.
+ * @chip:	0 for main chip, 1 for sub chip.
+ * @type:	One of &enum eiois200_snap.
+ * @ch:		Channel, the device id of the PMC command.
+ * @val:	The raw value, as returned by the EC.
+ * @client:	Client charged when the value has to be read live.
+ *
+ * A value sampled less than snapshot_ms ago is returned from the table,
+ * otherwise it is read live. The first read of a channel adds it to the
+ * periodic sampling, so the EC is asked once per interval no matter how
+ * many drivers poll it. It stays there until nobody read it for SNAP_IDLE
+ * intervals.
+ */
+int eiois200_core_snapshot(struct device *dev, u8 chip,
+			   enum eiois200_snap type, u8 ch, u16 *val,
+			   enum eiois200_client client)
+{
+	uint interval = READ_ONCE(snapshot_ms);
+	struct pmc_op op;
+	unsigned int seq;
+	ktime_t stamp;
+	bool valid;
+	u16 data;
+	int ret;
+
+	if (chip >= EIOIS200_EC_NUM || type >= EIOIS200_SNAP_NUM ||
+	    ch >= EIOIS200_SNAP_CH)
+		return -EINVAL;
+
+	if (interval) {
+		WRITE_ONCE(snap.used[chip][type][ch], jiffies);
+		if (!test_bit(ch, &snap.wanted[chip][type]))
+			set_bit(ch, &snap.wanted[chip][type]);
+
+		do {
+			seq   = read_seqbegin(&snap.lock);
+			data  = snap.ent[chip][type][ch].val;
+			valid = snap.ent[chip][type][ch].valid;
+			stamp = snap.ent[chip][type][ch].stamp;
+		} while (read_seqretry(&snap.lock, seq));
+
+		if (valid && ktime_ms_delta(ktime_get(), stamp) <= interval) {
+			atomic64_inc(&snap.hit);
+			*val = data;
+			return 0;
+		}
+
+		atomic64_inc(&snap.miss);
+		schedule_delayed_work(&snap.work, msecs_to_jiffies(interval));
+	}
+
+	data = 0;
+	op = (struct pmc_op) {
+		.cmd	   = snap_info[type].cmd,
+		.control   = snap_info[type].ctrl,
+		.device_id = ch,
+		.size	   = snap_info[type].size,
+		.payload   = (u8 *)&data,
+		.chip	   = chip,
+		.client	   = client,
+	};
+
+	ret = eiois200_core_pmc_operation(dev, &op);
+	if (!ret)
+		*val = data;
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(eiois200_core_snapshot);
+
+static void pmc_snapshot_release(void *data)
+{
+	cancel_delayed_work_sync(&snap.work);
+}
+
+static int pmc_snapshot_init(struct device *dev)
+{
+	snap.dev = dev;
+
+	return devm_add_action_or_reset(dev, pmc_snapshot_release, NULL);
+}
+
+/* Following are the deferred configuration save functions */
+/**
+ * pmc_save_update - Mark the configuration dirty after a PMC command
+ * @dev:	The device structure pointer.
+ * @op:		Pointer to an PMC command.
+ * @err:	The result of the command.
+ *
+ * A successful persistent write (re)starts the quiet period of save_ms.
+ */
+static void pmc_save_update(struct device *dev, struct pmc_op *op, int err)
+{
+	if (err || !op->persist || (op->cmd & EIOIS200_FLAG_PMC_READ) ||
+	    op->chip >= EIOIS200_EC_NUM)
+		return;
+
+	WRITE_ONCE(cfg_save.dev, dev);
+	set_bit(op->chip, &cfg_save.dirty);
+	atomic64_inc(&cfg_save.marked);
+
+	mod_delayed_work(system_wq, &cfg_save.work,
+			 msecs_to_jiffies(READ_ONCE(save_ms)));
+}
+
+/**
+ * pmc_save_run - Save the configuration of every dirty chip
+ *
+ * A chip whose save failed stays dirty, for the next sync or write.
+ * Returns:	0, or the first error.
+ */
+static int pmc_save_run(void)
+{
+	struct device *dev = READ_ONCE(cfg_save.dev);
+	int id, err = 0;
+
+	mutex_lock(&cfg_save.lock);
+
+	for (id = 0; id < EIOIS200_EC_NUM; id++) {
+		struct pmc_op op = {
+			.cmd	  = EIOIS200_PMC_CMD_CFG_SAVE,
+			.chip	  = id,
+			.priority = PMC_PRIO_BACKGROUND,
+		};
+		int ret;
+
+		if (!test_and_clear_bit(id, &cfg_save.dirty))
+			continue;
+
+		ret = eiois200_core_pmc_operation(dev, &op);
+		if (ret) {
+			dev_warn(dev, "EC%d configuration save failed (error = %d)\n",
+				 id, ret);
+			set_bit(id, &cfg_save.dirty);
+			atomic64_inc(&cfg_save.failed);
+			if (!err)
+				err = ret;
+			continue;
+		}
+
+		atomic64_inc(&cfg_save.saved);
+	}
+
+	mutex_unlock(&cfg_save.lock);
+
+	return err;
+}
+
+static void pmc_save_work(struct work_struct *work)
+{
+	pmc_save_run();
+}
+
+int eiois200_core_cfg_sync(struct device *dev)
+{
+	/* A pending delayed save then finds nothing left to do */
+	return pmc_save_run();
+}
+EXPORT_SYMBOL_GPL(eiois200_core_cfg_sync);
+
+static void pmc_save_release(void *data)
+{
+	cancel_delayed_work_sync(&cfg_save.work);
+	pmc_save_run();
+}
+
+/**
+ * pmc_dequeue - Take the next request to serve
+ * @chip:		The chip.
+ * @critical_only:	Only look at the critical queue.
+ */
+static struct pmc_request *pmc_dequeue(struct pmc_chip *chip,
+				       bool critical_only)
+{
+	struct pmc_request *req = NULL;
+	int i, prio = 0;
+
+	spin_lock(&chip->lock);
+
+	for (i = 0; i < ARRAY_SIZE(prio_order); i++) {
+		prio = prio_order[i];
+		req = list_first_entry_or_null(&chip->queue[prio],
+					       struct pmc_request, node);
+		if (req || critical_only)
+			break;
+	}
+
+	if (req) {
+		u64 wait = ktime_to_ns(ktime_sub(ktime_get(), req->queued));
+
+		list_del_init(&req->node);
+		chip->qstat[prio].depth--;
+		chip->qstat[prio].count++;
+		chip->qstat[prio].wait_ns += wait;
+		chip->qstat[prio].wait_max_ns = max(chip->qstat[prio].wait_max_ns,
+						    wait);
+	}
+
+	spin_unlock(&chip->lock);
+
+	return req;
+}
+
+static void pmc_finish(struct pmc_request *req)
+{
+	struct pmc_request *f, *tmp;
+
+	/* No one joins a dequeued request, the list is stable */
+	list_for_each_entry_safe(f, tmp, &req->followers, node) {
+		list_del_init(&f->node);
+
+		if (!req->result)
+			memcpy(f->ops[0].payload, req->ops[0].payload,
+			       req->ops[0].size);
+
+		f->result = req->result;
+		if (f->status)
+			f->status[0] = req->result;
+
+		pmc_finish(f);
+	}
+
+	/* The request may be freed by its owner from here on */
+	if (req->complete)
+		req->complete(req);
+	else
+		complete(&req->done);
+}
+
+static void pmc_stat_op(struct pmc_op *op, s64 lock_ns, s64 xfer_ns, int err)
+{
+	struct pmc_cmd_stat *stat = &pmc_stat[op->chip].cmd[op->cmd];
+
+	atomic64_inc(&stat->count);
+	atomic64_add(op->size, &stat->bytes);
+	atomic64_add(lock_ns, &stat->lock_ns);
+	pmc_hist_add(&stat->xfer, xfer_ns);
+
+	if (err == -ETIME) {
+		atomic64_inc(&stat->timeout);
+		trace_eiois200_pmc_timeout(op, lock_ns, xfer_ns, err);
+	} else if (err) {
+		atomic64_inc(&stat->error);
+	}
+
+	trace_eiois200_pmc_end(op, lock_ns, xfer_ns, err);
+}
+
+/**
+ * pmc_health_update - Track consecutive timeouts of a chip
+ * @chip:	The chip.
+ * @err:	Result of the last PMC transfer.
+ *
+ * Marks the chip failed after fail_max timeouts in a row and starts the
+ * recovery probe. Called from the chip worker with the chip mutex held.
+ */
+static void pmc_health_update(struct pmc_chip *chip, int err)
+{
+	if (err != -ETIME) {
+		if (!err)
+			chip->fails = 0;
+		return;
+	}
+
+	if (!fail_max || ++chip->fails < fail_max || chip->failed)
+		return;
+
+	WRITE_ONCE(chip->failed, true);
+	chip->trips++;
+	dev_warn(chip->dev, "PMC%d not responding after %u timeouts, fast-fail until recovered\n",
+		 (int)(chip - pmc_chip), chip->fails);
+
+	queue_delayed_work(chip->wq, &chip->recover,
+			   msecs_to_jiffies(recover_ms));
+}
+
+/* Check if a failed chip answers a firmware version read again */
+static void pmc_recover(struct work_struct *work)
+{
+	struct pmc_chip *chip = container_of(to_delayed_work(work),
+					     struct pmc_chip, recover);
+	int id = chip - pmc_chip;
+	u32 ver;
+	struct pmc_op op = {
+		.cmd	 = 0x53,
+		.control = 0x21,
+		.payload = (u8 *)&ver,
+		.size	 = sizeof(ver),
+		.chip	 = id,
+	};
+	int ret;
+
+	mutex_lock(&eiois200_dev->pmc_mutex[id]);
+	ret = pmc_transfer(chip->dev, &op);
+	mutex_unlock(&eiois200_dev->pmc_mutex[id]);
+
+	if (ret) {
+		queue_delayed_work(chip->wq, &chip->recover,
+				   msecs_to_jiffies(recover_ms));
+		return;
+	}
+
+	spin_lock(&chip->lock);
+	dev_info(chip->dev, "PMC%d recovered, %llu requests failed fast\n",
+		 id, chip->fast_fail);
+	chip->fast_fail = 0;
+	spin_unlock(&chip->lock);
+
+	chip->fails = 0;
+	WRITE_ONCE(chip->failed, false);
+}
+
+/**
+ * pmc_run - Run all commands of a request, the caller holds the chip lock
+ * @chip:	The chip.
+ * @req:	The request to execute.
+ *
+ * Critical requests queued meanwhile are served between the commands of a
+ * non-critical request, so a watchdog ping never waits for a whole batch.
+ * The lock wait of the first command counts from submission, that of the
+ * others from the end of the previous command.
+ */
+static void pmc_run(struct pmc_chip *chip, struct pmc_request *req)
+{
+	struct pmc_request *crit;
+	ktime_t ready = req->queued;
+	uint i;
+
+	req->result = 0;
+
+	for (i = 0; i < req->num; i++) {
+		ktime_t start = ktime_get();
+		s64 lock_ns = ktime_to_ns(ktime_sub(start, ready));
+		s64 xfer_ns;
+		int err;
+
+		trace_eiois200_pmc_start(&req->ops[i], lock_ns, 0, 0);
+
+		if (chip->failed) {
+			spin_lock(&chip->lock);
+			chip->fast_fail++;
+			spin_unlock(&chip->lock);
+			err = -EAGAIN;
+		} else {
+			err = pmc_transfer(req->dev, &req->ops[i]);
+			pmc_health_update(chip, err);
+		}
+
+		/* The next command waits only from here, not from submission */
+		ready	= ktime_get();
+		xfer_ns = ktime_to_ns(ktime_sub(ready, start));
+		pmc_stat_op(&req->ops[i], lock_ns, xfer_ns, err);
+		pmc_client_account(req->ops[i].client, 1, req->ops[i].size,
+				   xfer_ns);
+
+		pmc_cache_update(&req->ops[i], err);
+		pmc_snapshot_update(&req->ops[i], err);
+		pmc_save_update(req->dev, &req->ops[i], err);
+
+		if (req->status)
+			req->status[i] = err;
+
+		if (err && !req->result)
+			req->result = err;
+
+		if (req->priority == PMC_PRIO_CRITICAL || i + 1 == req->num)
+			continue;
+
+		while ((crit = pmc_dequeue(chip, true))) {
+			pmc_run(chip, crit);
+			pmc_finish(crit);
+		}
+	}
+}
+
+static bool pmc_op_same(const struct pmc_op *a, const struct pmc_op *b)
+{
+	return a->cmd == b->cmd && a->control == b->control &&
+	       a->device_id == b->device_id && a->size == b->size;
+}
+
+/**
+ * pmc_join - Attach a single read to an identical queued one
+ * @chip:	The chip, its lock held.
+ * @req:	The new request.
+ *
+ * Only the queue of the same priority is searched, newest first. A request
+ * writing the same command, control and device id stops the search, so a
+ * read never skips a write queued before it.
+ * Returns:	true if @req became a follower.
+ */
+static bool pmc_join(struct pmc_chip *chip, struct pmc_request *req)
+{
+	struct pmc_op *op = &req->ops[0];
+	struct pmc_request *lead;
+	uint i;
+
+	if (!coalesce || req->num != 1 || !(op->cmd & EIOIS200_FLAG_PMC_READ))
+		return false;
+
+	list_for_each_entry_reverse(lead, &chip->queue[req->priority], node) {
+		if (lead->num == 1 && pmc_op_same(&lead->ops[0], op)) {
+			list_add_tail(&req->node, &lead->followers);
+			chip->qstat[req->priority].coalesced++;
+			return true;
+		}
+
+		for (i = 0; i < lead->num; i++)
+			if ((lead->ops[i].cmd | EIOIS200_FLAG_PMC_READ) == op->cmd &&
+			    lead->ops[i].control == op->control &&
+			    lead->ops[i].device_id == op->device_id)
+				return false;
+	}
+
+	return false;
+}
+
+static void pmc_work(struct work_struct *work)
+{
+	struct pmc_chip *chip = container_of(work, struct pmc_chip, work);
+	int id = chip - pmc_chip;
+	struct pmc_request *req;
+
+	while ((req = pmc_dequeue(chip, false))) {
+		mutex_lock(&eiois200_dev->pmc_mutex[id]);
+		pmc_run(chip, req);
+		mutex_unlock(&eiois200_dev->pmc_mutex[id]);
+
+		pmc_finish(req);
+	}
+}
+
+/**
+ * eiois200_core_pmc_submit - Queue PMC commands to the chip worker
+ * @dev:	The device structure pointer.
+ * @req:	The request. &pmc_request.ops must all target the same chip.
+ *
+ * The commands are executed asynchronously under one hold of the chip lock.
+ * Requests are served by &pmc_request.priority, then in submission order.
+ * On completion &pmc_request.result holds 0 or the first error. Then
+ * &pmc_request.complete is called from the worker if set, otherwise
+ * &pmc_request.done is completed.
+ *
+ * A request of one read identical to a queued one of the same priority
+ * completes together with it instead, see pmc_join().
+ *
+ * While the chip is marked failed after repeated timeouts, the request is
+ * rejected with -EAGAIN without being queued.
+ *
+ * The complete callback runs in the chip worker. It must not sleep on other
+ * PMC requests, including the synchronous eiois200_core_pmc_operation().
+ */
+int eiois200_core_pmc_submit(struct device *dev, struct pmc_request *req)
+{
+	struct pmc_chip *chip;
+	uint i;
+
+	if (!req->num)
+		return -EINVAL;
+
+	if (!eiois200_chip_exist(eiois200_dev, req->ops[0].chip))
+		return -ENODEV;
+
+	for (i = 1; i < req->num; i++)
+		if (req->ops[i].chip != req->ops[0].chip)
+			return -EINVAL;
+
+	if (req->priority >= PMC_PRIO_NUM)
+		return -EINVAL;
+
+	chip = &pmc_chip[req->ops[0].chip];
+	if (READ_ONCE(chip->failed)) {
+		spin_lock(&chip->lock);
+		chip->fast_fail++;
+		spin_unlock(&chip->lock);
+		return -EAGAIN;
+	}
+
+	req->dev = dev;
+	req->queued = ktime_get();
+	init_completion(&req->done);
+	INIT_LIST_HEAD(&req->followers);
+
+	spin_lock(&chip->lock);
+
+	if (pmc_join(chip, req)) {
+		spin_unlock(&chip->lock);
+		return 0;
+	}
+
+	list_add_tail(&req->node, &chip->queue[req->priority]);
+	chip->qstat[req->priority].depth++;
+	chip->qstat[req->priority].depth_max =
+		max(chip->qstat[req->priority].depth_max,
+		    chip->qstat[req->priority].depth);
+	spin_unlock(&chip->lock);
+
+	queue_work(chip->wq, &chip->work);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(eiois200_core_pmc_submit);
+
+static int pmc_submit_wait(struct device *dev, struct pmc_request *req)
+{
+	int ret;
+
+	ret = eiois200_core_pmc_submit(dev, req);
+	if (ret)
+		return ret;
+
+	wait_for_completion(&req->done);
+
+	return req->result;
+}
+
+/**
+ * eiois200_core_pmc_operation - Execute a PMC command
+ * @dev:	The device structure pointer.
+ * @op:		Pointer to an PMC command.
+ *
+ * A read served from the cache is not charged to &pmc_op.client.
+ */
+int eiois200_core_pmc_operation(struct device *dev,
+				struct pmc_op *op)
+{
+	struct pmc_request req = {
+		.ops	  = op,
+		.num	  = 1,
+		.priority = op->priority,
+	};
+
+	int ret;
+
+	if (pmc_cache_get(op))
+		return 0;
+
+	ret = pmc_client_admit(op->client, 1);
+	if (ret)
+		return ret;
+
+	return pmc_submit_wait(dev, &req);
+}
+EXPORT_SYMBOL_GPL(eiois200_core_pmc_operation);
+
+/**
+ * eiois200_core_pmc_batch - Execute PMC commands under one lock hold
+ * @dev:	The device structure pointer.
+ * @ops:	Array of PMC commands, all targeting the same chip.
+ * @num:	Number of commands in @ops.
+ * @status:	Optional array of @num results, one per command.
+ *
+ * Every command is executed even if a previous one failed. The batch is
+ * charged to the client of the first command. If the batch is rejected
+ * before any command is sent, every @status entry is set to the error.
+ * Returns:	0 if all commands succeeded, or the first error.
+ */
+int eiois200_core_pmc_batch(struct device *dev,
+			    struct pmc_op *ops,
+			    uint num,
+			    int *status)
+{
+	struct pmc_request req = {
+		.ops	  = ops,
+		.num	  = num,
+		.status	  = status,
+		.priority = num ? ops[0].priority : 0,
+	};
+	uint i;
+	int ret;
+
+	if (!num)
+		return 0;
+
+	ret = pmc_client_admit(ops[0].client, num);
+	if (!ret)
+		ret = eiois200_core_pmc_submit(dev, &req);
+
+	if (ret) {
+		/* Nothing was sent, every command gets the error */
+		for (i = 0; status && i < num; i++)
+			status[i] = ret;
+
+		return ret;
+	}
+
+	wait_for_completion(&req.done);
+
+	return req.result;
+}
+EXPORT_SYMBOL_GPL(eiois200_core_pmc_batch);
+
+static void pmc_queue_release(void *data)
+{
+	struct pmc_chip *chip = data;
+
+	cancel_delayed_work_sync(&chip->recover);
+	destroy_workqueue(chip->wq);
+}
+
+static int pmc_queue_init(struct device *dev, int id)
+{
+	struct pmc_chip *chip = &pmc_chip[id];
+
+	int prio;
+
+	spin_lock_init(&chip->lock);
+	for (prio = 0; prio < PMC_PRIO_NUM; prio++)
+		INIT_LIST_HEAD(&chip->queue[prio]);
+	INIT_WORK(&chip->work, pmc_work);
+	INIT_DELAYED_WORK(&chip->recover, pmc_recover);
+	ratelimit_state_init(&chip->rs, DEFAULT_RATELIMIT_INTERVAL,
+			     DEFAULT_RATELIMIT_BURST);
+	chip->dev = dev;
+	pmc_learn_init(id);
+
+	chip->wq = alloc_ordered_workqueue("eiois200_pmc%d", WQ_HIGHPRI, id);
+	if (!chip->wq)
+		return -ENOMEM;
+
+	return devm_add_action_or_reset(dev, pmc_queue_release, chip);
+}
+
+/**
+ * pmc_learn_calibrate - Seed the learned EC timing of each chip
+ * @dev:	The device structure pointer.
+ *
+ * Runs a few cheap reads so the first requests of the sub-drivers already
+ * poll at the measured pace. Failures are left to the normal paths.
+ */
+static void pmc_learn_calibrate(struct device *dev)
+{
+	int chip, i;
+
+	for (chip = 0; chip < EIOIS200_EC_NUM; chip++) {
+		if (!eiois200_chip_exist(eiois200_dev, chip))
+			continue;
+
+		for (i = 0; i < LEARN_LOOPS; i++) {
+			u32 val;
+			struct pmc_op op = {
+				.cmd	 = 0x53,
+				.control = 0x21,
+				.payload = (u8 *)&val,
+				.size	 = sizeof(val),
+				.chip	 = chip,
+			};
+
+			if (eiois200_core_pmc_operation(dev, &op))
+				break;
+		}
+
+		dev_dbg(dev, "pmc%d latency %uus, poll %uus, timeout %uus\n",
+			chip, pmc_chip[chip].srtt >> 3, pmc_chip[chip].poll_us,
+			pmc_timeout(chip));
+	}
+}
+
+static int get_pmc_port(struct device *dev, int id, u8 sioctrl)
+{
+	struct _pmc_port *pmc = &eiois200_dev->pmc[id];
+	struct pnp_op ops[] = {
+		/* Turn on the enable flag */
+		{ .reg = EIOIS200_SIOCTRL, .write = true,
+		  .val = sioctrl | EIOIS200_SIOCTRL_SIOEN },
+
+		/* Active the PMC device */
+		{ .ldn = EIOIS200_LDN_PMC1, .reg = EIOIS200_LDAR, .write = true,
+		  .val = EIOIS200_LDAR_LDACT },
+
+		/* Get PMC cmd and data port */
+		{ .ldn = EIOIS200_LDN_PMC1, .reg = EIOIS200_IOBA0H },
+		{ .ldn = EIOIS200_LDN_PMC1, .reg = EIOIS200_IOBA0L },
+		{ .ldn = EIOIS200_LDN_PMC1, .reg = EIOIS200_IOBA1H },
+		{ .ldn = EIOIS200_LDN_PMC1, .reg = EIOIS200_IOBA1L },
+
+		/* Disable IRQ */
+		{ .ldn = EIOIS200_LDN_PMC1, .reg = EIOIS200_IRQCTRL, .write = true },
+	};
+	int ret;
+
+	ret = pnp_batch(dev, id, ops, ARRAY_SIZE(ops));
+	if (ret)
+		return ret;
+
+	pmc->data = (ops[2].val << 8) | ops[3].val;
+	pmc->cmd  = (ops[4].val << 8) | ops[5].val;
+
+	/* Make sure IO ports are not occupied */
+	if (!sim_chips && !devm_request_region(dev, pmc->data, 2, KBUILD_MODNAME)) {
+		dev_err(dev, "Request region %X error\n", pmc->data);
+		return -EBUSY;
+	}
+
+	return 0;
+}
+
+/**
+ * pmc_io_init - Map the PMC data and command/status ports
+ * @dev:	The device structure pointer.
+ * @id:		0 for main chip, 1 for sub chip.
+ *
+ * The ports are mapped even without fast_io, the bench debugfs file
+ * compares both access paths.
+ */
+static int pmc_io_init(struct device *dev, int id)
+{
+	struct pmc_chip *chip = &pmc_chip[id];
+	int reg;
+
+	/* The simulated ports only exist in the regmap */
+	if (sim_chips)
+		return 0;
+
+	for (reg = 0; reg < PMC_IO_NUM; reg++) {
+		chip->io[reg] = devm_ioport_map(dev, pmc_io_port(id, reg), 1);
+		if (!chip->io[reg])
+			return -ENOMEM;
+	}
+
+	chip->fast_io = fast_io;
+
+	return 0;
+}
+
+static int queue_show(struct seq_file *s, void *unused)
+{
+	int id, prio;
+
+	seq_puts(s, "chip priority    depth max_depth count wait_avg_us wait_max_us coalesced\n");
+
+	for (id = 0; id < EIOIS200_EC_NUM; id++) {
+		struct pmc_chip *chip = &pmc_chip[id];
+
+		if (!eiois200_chip_exist(eiois200_dev, id))
+			continue;
+
+		spin_lock(&chip->lock);
+		for (prio = 0; prio < PMC_PRIO_NUM; prio++) {
+			u64 count = chip->qstat[prio].count;
+
+			seq_printf(s, "%-4d %-11s %5u %9u %5llu %11llu %11llu %9llu\n",
+				   id, prio_name[prio],
+				   chip->qstat[prio].depth,
+				   chip->qstat[prio].depth_max, count,
+				   count ? div64_u64(chip->qstat[prio].wait_ns,
+						     count * NSEC_PER_USEC) : 0,
+				   div64_u64(chip->qstat[prio].wait_max_ns,
+					     NSEC_PER_USEC),
+				   chip->qstat[prio].coalesced);
+		}
+		spin_unlock(&chip->lock);
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(queue);
+
+static int budget_show(struct seq_file *s, void *unused)
+{
+	int id;
+
+	seq_printf(s, "budget_us: %u\n", budget);
+	seq_puts(s, "chip count used_avg_us used_max_us expired\n");
+
+	for (id = 0; id < EIOIS200_EC_NUM; id++) {
+		struct pmc_chip *chip = &pmc_chip[id];
+
+		if (!eiois200_chip_exist(eiois200_dev, id))
+			continue;
+
+		spin_lock(&chip->lock);
+		seq_printf(s, "%-4d %5llu %11llu %11llu %7llu\n", id,
+			   chip->bstat.count,
+			   chip->bstat.count ? div64_u64(chip->bstat.used_us,
+							 chip->bstat.count) : 0,
+			   chip->bstat.used_max_us, chip->bstat.expired);
+		spin_unlock(&chip->lock);
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(budget);
+
+static int health_show(struct seq_file *s, void *unused)
+{
+	int id;
+
+	seq_puts(s, "chip state  timeouts trips fast_fail\n");
+
+	for (id = 0; id < EIOIS200_EC_NUM; id++) {
+		struct pmc_chip *chip = &pmc_chip[id];
+
+		if (!eiois200_chip_exist(eiois200_dev, id))
+			continue;
+
+		seq_printf(s, "%-4d %-6s %8u %5llu %9llu\n", id,
+			   READ_ONCE(chip->failed) ? "failed" : "ok",
+			   chip->fails, chip->trips, chip->fast_fail);
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(health);
+
+static int cache_show(struct seq_file *s, void *unused)
+{
+	spin_lock(&pmc_cache_lock);
+	seq_printf(s, "entries:    %u\n", cstat.num);
+	seq_printf(s, "hit:        %llu\n", cstat.hit);
+	seq_printf(s, "miss:       %llu\n", cstat.miss);
+	seq_printf(s, "invalidate: %llu\n", cstat.invalidate);
+	spin_unlock(&pmc_cache_lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(cache);
+
+static int save_show(struct seq_file *s, void *unused)
+{
+	seq_printf(s, "dirty:   0x%lx\n", READ_ONCE(cfg_save.dirty));
+	seq_printf(s, "pending: %s\n",
+		   delayed_work_pending(&cfg_save.work) ? "yes" : "no");
+	seq_printf(s, "writes:  %llu\n", (u64)atomic64_read(&cfg_save.marked));
+	seq_printf(s, "saved:   %llu\n", (u64)atomic64_read(&cfg_save.saved));
+	seq_printf(s, "failed:  %llu\n", (u64)atomic64_read(&cfg_save.failed));
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(save);
+
+static int clients_show(struct seq_file *s, void *unused)
+{
+	int i;
+
+	seq_puts(s, "client  rate  count      bytes      busy_us    throttled\n");
+
+	for (i = 0; i < EIOIS200_CLIENT_NUM; i++) {
+		struct pmc_client *c = &pmc_client[i];
+
+		seq_printf(s, "%-7s %-5u %-10llu %-10llu %-10llu %llu\n",
+			   client_name[i], READ_ONCE(client_rate[i]),
+			   (u64)atomic64_read(&c->count),
+			   (u64)atomic64_read(&c->bytes),
+			   div_u64(atomic64_read(&c->busy_ns), NSEC_PER_USEC),
+			   (u64)atomic64_read(&c->throttled));
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(clients);
+
+static int pnp_show(struct seq_file *s, void *unused)
+{
+	int chip, ldn, i;
+
+	mutex_lock(&eiois200_dev->mutex);
+	for (chip = 0; chip < EIOIS200_EC_NUM; chip++) {
+		seq_printf(s, "pnp%d hit: %llu enter: %llu\n", chip,
+			   pnp_cache[chip].hit, pnp_cache[chip].enter);
+
+		for (ldn = 0; ldn < ARRAY_SIZE(pnp_cache[chip].valid); ldn++) {
+			if (!pnp_cache[chip].valid[ldn])
+				continue;
+
+			seq_printf(s, "  ldn 0x%02X:", ldn);
+			for (i = 0; i < ARRAY_SIZE(pnp_cached_regs); i++)
+				if (pnp_cache[chip].valid[ldn] & BIT(i))
+					seq_printf(s, " %02X=%02X", pnp_cached_regs[i],
+						   pnp_cache[chip].val[ldn][i]);
+			seq_putc(s, '\n');
+		}
+	}
+	mutex_unlock(&eiois200_dev->mutex);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(pnp);
+
+/**
+ * acpiram_read - Read a range of the ACPI RAM stored in the EC
+ * @dev:	The device structure pointer.
+ * @offset:	The offset of the first byte.
+ * @buf:	Buffer of @len bytes.
+ * @len:	Number of bytes, offset + len must not pass the ACPI RAM end.
+ *
+ * The range is read as one batch of ACPIRAM_CHUNK byte commands, so it
+ * goes through the chip worker like any other PMC request. Each command
+ * has its own budget.
+ */
+static int acpiram_read(struct device *dev, u8 offset, u8 *buf, uint len)
+{
+	struct pmc_op ops[ACPIRAM_SIZE / ACPIRAM_CHUNK];
+	uint pos, num = 0;
+
+	if (!len || offset + len > ACPIRAM_SIZE)
+		return -EINVAL;
+
+	/* We only store information on primary EC */
+	for (pos = 0; pos < len; pos += ACPIRAM_CHUNK)
+		ops[num++] = (struct pmc_op) {
+			.cmd	 = EIOIS200_PMC_CMD_ACPIRAM_READ,
+			.control = offset + pos,
+			.size	 = min_t(uint, len - pos, ACPIRAM_CHUNK),
+			.payload = &buf[pos],
+			.chip	 = 0,
+		};
+
+	return eiois200_core_pmc_batch(dev, ops, num, NULL);
+}
+
+/* The whole ACPI RAM of the main chip, read under one lock hold */
+static ssize_t acpiram_dump(struct file *file, char __user *ubuf,
+			    size_t count, loff_t *ppos)
+{
+	u8 *buf;
+	ssize_t ret;
+
+	if (*ppos >= ACPIRAM_SIZE)
+		return 0;
+
+	buf = kmalloc(ACPIRAM_SIZE, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	ret = acpiram_read(pmc_chip[0].dev, 0, buf, ACPIRAM_SIZE);
+	if (!ret)
+		ret = simple_read_from_buffer(ubuf, count, ppos, buf,
+					      ACPIRAM_SIZE);
+
+	kfree(buf);
+
+	return ret;
+}
+
+static const struct file_operations acpiram_fops = {
+	.owner  = THIS_MODULE,
+	.open   = simple_open,
+	.read   = acpiram_dump,
+	.llseek = default_llseek,
+};
+
+static int snapshot_show(struct seq_file *s, void *unused)
+{
+	ktime_t now = ktime_get();
+	int chip, type, ch;
+
+	seq_printf(s, "interval_ms: %u\n", snapshot_ms);
+	seq_printf(s, "hit:         %lld\n", (s64)atomic64_read(&snap.hit));
+	seq_printf(s, "miss:        %lld\n", (s64)atomic64_read(&snap.miss));
+	seq_puts(s, "chip type     ch value  age_ms\n");
+
+	read_seqlock_excl(&snap.lock);
+	for (chip = 0; chip < EIOIS200_EC_NUM; chip++)
+		for (type = 0; type < EIOIS200_SNAP_NUM; type++)
+			for_each_set_bit(ch, &snap.wanted[chip][type],
+					 EIOIS200_SNAP_CH) {
+				struct snap_entry *e = &snap.ent[chip][type][ch];
+
+				seq_printf(s, "%-4d %-8s %2d %5u %7lld\n",
+					   chip, snap_info[type].name, ch, e->val,
+					   e->valid ? ktime_ms_delta(now, e->stamp) : -1);
+			}
+	read_sequnlock_excl(&snap.lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(snapshot);
+
+/*
+ * Time BENCH_LOOPS status port reads through each access path. Reading the
+ * status has no side effect, so this is safe while commands are running.
+ */
+static int bench_show(struct seq_file *s, void *unused)
+{
+	int id;
+
+	seq_puts(s, "chip path    ns/byte\n");
+
+	for (id = 0; id < EIOIS200_EC_NUM; id++) {
+		struct pmc_chip *chip = &pmc_chip[id];
+		u16 port = pmc_io_port(id, PMC_IO_CMD);
+		ktime_t start;
+		uint val;
+		int i;
+
+		if (!eiois200_chip_exist(eiois200_dev, id))
+			continue;
+
+		start = ktime_get();
+		for (i = 0; i < BENCH_LOOPS; i++)
+			if (regmap_read(regmap_is200, port, &val))
+				return -EIO;
+		seq_printf(s, "%-4d %-7s %7llu\n", id, "regmap",
+			   div_u64(ktime_to_ns(ktime_sub(ktime_get(), start)),
+				   BENCH_LOOPS));
+
+		if (!chip->io[PMC_IO_CMD])
+			continue;
+
+		start = ktime_get();
+		for (i = 0; i < BENCH_LOOPS; i++)
+			val = ioread8(chip->io[PMC_IO_CMD]);
+		seq_printf(s, "%-4d %-7s %7llu\n", id, "ioread8",
+			   div_u64(ktime_to_ns(ktime_sub(ktime_get(), start)),
+				   BENCH_LOOPS));
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(bench);
+
+static int stats_show(struct seq_file *s, void *unused)
+{
+	int id, cmd;
+
+	seq_puts(s, "chip cmd   count      bytes      timeout error lock_avg_us\n");
+
+	for (id = 0; id < EIOIS200_EC_NUM; id++) {
+		for (cmd = 0; cmd < CMD_NUM; cmd++) {
+			struct pmc_cmd_stat *stat = &pmc_stat[id].cmd[cmd];
+			u64 count = atomic64_read(&stat->count);
+
+			if (!count)
+				continue;
+
+			seq_printf(s, "%-4d 0x%02X  %-10llu %-10llu %-7llu %-5llu %llu\n",
+				   id, cmd, count,
+				   (u64)atomic64_read(&stat->bytes),
+				   (u64)atomic64_read(&stat->timeout),
+				   (u64)atomic64_read(&stat->error),
+				   div64_u64(atomic64_read(&stat->lock_ns),
+					     count * NSEC_PER_USEC));
+		}
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(stats);
+
+static void hist_show_one(struct seq_file *s, const char *name,
+			  struct pmc_hist *hist)
+{
+	int i;
+
+	seq_printf(s, "%-10s", name);
+	for (i = 0; i < HIST_NUM; i++)
+		seq_printf(s, " %u", atomic_read(&hist->bucket[i]));
+	seq_putc(s, '\n');
+}
+
+static int hist_show(struct seq_file *s, void *unused)
+{
+	char name[16];
+	int id, cmd, i;
+
+	seq_puts(s, "# log2 usec buckets: <1");
+	for (i = 1; i < HIST_NUM - 1; i++)
+		seq_printf(s, " <%lu", BIT(i));
+	seq_printf(s, " >=%lu\n", BIT(HIST_NUM - 2));
+
+	for (id = 0; id < EIOIS200_EC_NUM; id++) {
+		if (!eiois200_chip_exist(eiois200_dev, id))
+			continue;
+
+		snprintf(name, sizeof(name), "%d:wait", id);
+		hist_show_one(s, name, &pmc_stat[id].wait);
+
+		for (cmd = 0; cmd < CMD_NUM; cmd++) {
+			if (!atomic64_read(&pmc_stat[id].cmd[cmd].count))
+				continue;
+
+			snprintf(name, sizeof(name), "%d:0x%02X", id, cmd);
+			hist_show_one(s, name, &pmc_stat[id].cmd[cmd].xfer);
+		}
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(hist);
+
+static void pmc_hist_reset(struct pmc_hist *hist)
+{
+	int i;
+
+	for (i = 0; i < HIST_NUM; i++)
+		atomic_set(&hist->bucket[i], 0);
+}
+
+/* Any write clears the stats, hist and clients counters */
+static ssize_t reset_write(struct file *file, const char __user *buf,
+			   size_t count, loff_t *ppos)
+{
+	int id, cmd;
+
+	for (id = 0; id < EIOIS200_EC_NUM; id++) {
+		pmc_hist_reset(&pmc_stat[id].wait);
+
+		for (cmd = 0; cmd < CMD_NUM; cmd++) {
+			struct pmc_cmd_stat *stat = &pmc_stat[id].cmd[cmd];
+
+			atomic64_set(&stat->count, 0);
+			atomic64_set(&stat->bytes, 0);
+			atomic64_set(&stat->timeout, 0);
+			atomic64_set(&stat->error, 0);
+			atomic64_set(&stat->lock_ns, 0);
+			pmc_hist_reset(&stat->xfer);
+		}
+	}
+
+	for (id = 0; id < EIOIS200_CLIENT_NUM; id++) {
+		atomic64_set(&pmc_client[id].count, 0);
+		atomic64_set(&pmc_client[id].bytes, 0);
+		atomic64_set(&pmc_client[id].busy_ns, 0);
+		atomic64_set(&pmc_client[id].throttled, 0);
+	}
+
+	return count;
+}
+
+static const struct file_operations reset_fops = {
+	.owner = THIS_MODULE,
+	.open  = simple_open,
+	.write = reset_write,
+};
+
+static void eiois200_debugfs_release(void *data)
+{
+	debugfs_remove_recursive(debugfs_dir);
+	debugfs_dir = NULL;
+}
+
+static int eiois200_debugfs_init(struct device *dev)
+{
+	debugfs_dir = debugfs_create_dir(KBUILD_MODNAME, NULL);
+
+	debugfs_create_file("queue", 0444, debugfs_dir, NULL, &queue_fops);
+	debugfs_create_file("cache", 0444, debugfs_dir, NULL, &cache_fops);
+	debugfs_create_file("pnp", 0444, debugfs_dir, NULL, &pnp_fops);
+	debugfs_create_file("save", 0444, debugfs_dir, NULL, &save_fops);
+	debugfs_create_file("snapshot", 0444, debugfs_dir, NULL, &snapshot_fops);
+	debugfs_create_file_size("acpiram", 0400, debugfs_dir, NULL,
+				 &acpiram_fops, ACPIRAM_SIZE);
+	debugfs_create_file("budget", 0444, debugfs_dir, NULL, &budget_fops);
+	debugfs_create_file("health", 0444, debugfs_dir, NULL, &health_fops);
+	debugfs_create_file("bench", 0400, debugfs_dir, NULL, &bench_fops);
+	debugfs_create_file("stats", 0444, debugfs_dir, NULL, &stats_fops);
+	debugfs_create_file("clients", 0444, debugfs_dir, NULL, &clients_fops);
+	debugfs_create_file("hist", 0444, debugfs_dir, NULL, &hist_fops);
+	debugfs_create_file("reset", 0200, debugfs_dir, NULL, &reset_fops);
+
+	return devm_add_action_or_reset(dev, eiois200_debugfs_release, NULL);
+}
+
+/* Read commands /dev/eiois200 accepts without ioctl_writes */
+static const u8 ioctl_reads[] = {
+	0x11,	/* Thermal protect */
+	0x13,	/* Voltage */
+	0x15,	/* Current */
+	0x17,	/* Tacho */
+	0x19,	/* GPIO */
+	0x21,	/* Backlight */
+	0x25,	/* Fan */
+	0x29,	/* Case open */
+	0x2B,	/* Watchdog */
+	EIOIS200_PMC_CMD_ACPIRAM_READ,
+	0x53,	/* Board information */
+	0x55,	/* Counters */
+};
+
+static bool ioctl_cmd_allowed(u8 cmd)
+{
+	int i;
+
+	if (cmd & EIOIS200_FLAG_PMC_READ) {
+		for (i = 0; i < ARRAY_SIZE(ioctl_reads); i++)
+			if (ioctl_reads[i] == cmd)
+				return true;
+		return false;
+	}
+
+	for (i = 0; i < ioctl_writes_num; i++)
+		if (ioctl_writes[i] == cmd)
+			return true;
+
+	return false;
+}
+
+static struct miscdevice pmc_misc;
+
+static long pmc_ioctl_batch(struct eiois200_pmc_batch __user *arg)
+{
+	struct eiois200_pmc_batch batch;
+	struct eiois200_pmc_xfer *xfer;
+	struct pmc_op *ops;
+	int *status;
+	uint i;
+	int ret;
+
+	if (copy_from_user(&batch, arg, sizeof(batch)))
+		return -EFAULT;
+
+	if (batch.reserved || !batch.num || batch.num > EIOIS200_PMC_BATCH_MAX)
+		return -EINVAL;
+
+	xfer = memdup_user(u64_to_user_ptr(batch.xfers),
+			   batch.num * sizeof(*xfer));
+	if (IS_ERR(xfer))
+		return PTR_ERR(xfer);
+
+	ops    = kcalloc(batch.num, sizeof(*ops), GFP_KERNEL);
+	status = kcalloc(batch.num, sizeof(*status), GFP_KERNEL);
+	if (!ops || !status) {
+		ret = -ENOMEM;
+		goto exit;
+	}
+
+	if (xfer[0].chip >= EIOIS200_EC_NUM) {
+		ret = -ENODEV;
+		goto exit;
+	}
+
+	for (i = 0; i < batch.num; i++) {
+		if (xfer[i].chip != xfer[0].chip ||
+		    xfer[i].size > EIOIS200_PMC_XFER_DATA ||
+		    memchr_inv(xfer[i].reserved, 0, sizeof(xfer[i].reserved))) {
+			ret = -EINVAL;
+			goto exit;
+		}
+
+		if (!ioctl_cmd_allowed(xfer[i].cmd)) {
+			ret = -EPERM;
+			goto exit;
+		}
+
+		ops[i] = (struct pmc_op) {
+			.cmd	   = xfer[i].cmd,
+			.control   = xfer[i].control,
+			.device_id = xfer[i].device_id,
+			.size	   = xfer[i].size,
+			.payload   = xfer[i].data,
+			.chip	   = xfer[i].chip,
+			.client	   = EIOIS200_CLIENT_CHARDEV,
+		};
+	}
+
+	/* Per command errors are reported in status */
+	ret = eiois200_core_pmc_batch(pmc_misc.parent, ops, batch.num, status);
+	if (ret == -ENODEV || ret == -EAGAIN || ret == -EBUSY)
+		goto exit;
+
+	for (i = 0; i < batch.num; i++)
+		xfer[i].status = status[i];
+
+	ret = copy_to_user(u64_to_user_ptr(batch.xfers), xfer,
+			   batch.num * sizeof(*xfer)) ? -EFAULT : 0;
+
+exit:
+	kfree(status);
+	kfree(ops);
+	kfree(xfer);
+
+	return ret;
+}
+
+static long pmc_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
+{
+	switch (cmd) {
+	case EIOIS200_IOC_PMC_BATCH:
+		return pmc_ioctl_batch((void __user *)arg);
+	default:
+		return -ENOTTY;
+	}
+}
+
+static const struct file_operations pmc_misc_fops = {
+	.owner		= THIS_MODULE,
+	.unlocked_ioctl	= pmc_ioctl,
+	.compat_ioctl	= compat_ptr_ioctl,
+	.llseek		= noop_llseek,
+};
+
+static struct miscdevice pmc_misc = {
+	.minor = MISC_DYNAMIC_MINOR,
+	.name  = "eiois200",
+	.fops  = &pmc_misc_fops,
+	.mode  = 0600,
+};
+
+static void pmc_misc_release(void *data)
+{
+	misc_deregister(&pmc_misc);
+}
+
+static int pmc_misc_init(struct device *dev)
+{
+	int ret;
+
+	pmc_misc.parent = dev;
+
+	ret = misc_register(&pmc_misc);
+	if (ret)
+		return ret;
+
+	return devm_add_action_or_reset(dev, pmc_misc_release, NULL);
+}
+
+/**
+ * pmc_irq_init - Switch a chip to IRQ driven PMC completion
+ * @dev:	The device structure pointer.
+ * @id:		0 for main chip, 1 for sub chip.
+ *
+ * Falls back to polling mode if the IRQ cannot be requested.
+ */
+static void pmc_irq_init(struct device *dev, int id)
+{
+	struct pmc_chip *chip = &pmc_chip[id];
+	struct pnp_op op = {
+		.ldn   = EIOIS200_LDN_PMC1,
+		.reg   = EIOIS200_IRQCTRL,
+		.val   = pmc_irq[id],
+		.write = true,
+	};
+	int ret;
+
+	init_completion(&chip->obf);
+
+	/* The simulator does not raise interrupts */
+	if (pmc_irq[id] <= 0 || sim_chips)
+		return;
+
+	ret = devm_request_irq(dev, pmc_irq[id], pmc_isr, IRQF_SHARED,
+			       KBUILD_MODNAME, chip);
+	if (ret) {
+		dev_warn(dev, "PMC%d IRQ %d request fail:%d. Use polling.\n",
+			 id, pmc_irq[id], ret);
+		return;
+	}
+
+	if (pnp_batch(dev, id, &op, 1))
+		return;
+
+	chip->irq = pmc_irq[id];
+	dev_dbg(dev, "PMC%d uses IRQ %d\n", id, chip->irq);
+}
+
+static int eiois200_init(struct device *dev)
+{
+	u16  chip_id = 0;
+	int  chip = 0;
+	int  ret = -ENOMEM;
+
+	for (chip = 0; chip < ARRAY_SIZE(pnp_port); chip++) {
+		struct pnp_op ops[] = {
+			{ .reg = EIOIS200_CHIPID1 },
+			{ .reg = EIOIS200_CHIPID2 },
+			{ .reg = EIOIS200_SIOCTRL },
+		};
+
+		if (!sim_chips &&
+		    !devm_request_region(dev,
+					 pnp_port[chip].idx_port,
+					 pnp_port[chip].data_port -
+					 pnp_port[chip].idx_port,
+					 KBUILD_MODNAME))
+			continue;
+
+		if (pnp_batch(dev, chip, ops, ARRAY_SIZE(ops)))
+			continue;
+
+		chip_id = (ops[0].val << 8) | ops[1].val;
+
+		if (chip_id != EIOIS200_CHIPID &&
+		    chip_id != EIO201_211_CHIPID)
+			continue;
+
+		ret = get_pmc_port(dev, chip, ops[2].val);
+		if (ret)
+			return ret;
+
+		ret = pmc_io_init(dev, chip);
+		if (ret)
+			return ret;
+
+		ret = pmc_queue_init(dev, chip);
+		if (ret)
+			return ret;
+
+		pmc_irq_init(dev, chip);
+
+		if (chip == 0)
+			eiois200_dev->flag |= EIOIS200_F_CHIP_EXIST;
+		else
+			eiois200_dev->flag |= EIOIS200_F_SUB_CHIP_EXIST;
+	}
+
+	return ret;
+}
+
+/**
+ * acpiram_access - Read ACPI information stored in the EC
+ * @dev:	The device structure pointer.
+ * @offset:	The offset of information.
+ * Returns:	The value read from the PMC, or 0 if there was an error.
+ */
+static uint8_t acpiram_access(struct device *dev, uint8_t offset)
+{
+	u8 val;
+
+	return acpiram_read(dev, offset, &val, sizeof(val)) ? 0 : val;
+}
+
+static int firmware_code_base(struct device *dev)
+{
+	u8 ver[3];
+	u8 ic_vendor, ic_code, code_base;
+
+	/* The whole version section in one go */
+	if (acpiram_read(dev, EIOIS200_ACPIRAM_VERSIONSECTION, ver, sizeof(ver)))
+		return -ENODEV;
+
+	ic_vendor = ver[EIOIS200_ACPIRAM_ICVENDOR - EIOIS200_ACPIRAM_VERSIONSECTION];
+	ic_code   = ver[EIOIS200_ACPIRAM_ICCODE - EIOIS200_ACPIRAM_VERSIONSECTION];
+	code_base = ver[EIOIS200_ACPIRAM_CODEBASE - EIOIS200_ACPIRAM_VERSIONSECTION];
+
+	if (ic_vendor != 'R')
+		return -ENODEV;
+
+	if (ic_code != EIOIS200_ICCODE &&
+	    ic_code != EIO201_ICCODE   &&
+	    ic_code != EIO211_ICCODE)
+		goto err;
+
+	if (code_base == EIOIS200_ACPIRAM_CODEBASE_NEW) {
+		eiois200_dev->flag |= EIOIS200_F_NEW_CODE_BASE;
+		return 0;
+	}
+
+	if (code_base == 0 && (ic_code != EIO201_ICCODE &&
+			       ic_code != EIO211_ICCODE)) {
+		dev_info(dev, "Old code base not supported, yet.");
+		return -ENODEV;
+	}
+
+ err:
+	/* Codebase error. This should only happen on firmware error. */
+	dev_err(dev, "Codebase check fail: vendor: 0x%X, code: 0x%X, base: 0x%X\n",
+		ic_vendor, ic_code, code_base);
+	return -ENODEV;
+}
+
+/*
+ * Children probe asynchronously. Log how long each one took to probe and
+ * how long after its registration it became ready.
+ */
+static struct {
+	struct device *parent;
+	ktime_t added;
+	ktime_t bind[EIOIS200_EC_NUM][CELL_NUM];
+} cells;
+
+static int cell_index(struct device *dev)
+{
+	int i;
+
+	if (dev->parent != cells.parent)
+		return -1;
+
+	for (i = 0; i < CELL_NUM; i++)
+		if (!strcmp(to_platform_device(dev)->name, mfd_devs[0][i].name))
+			return i;
+
+	return -1;
+}
+
+static int cell_notify(struct notifier_block *nb,
+		       unsigned long action, void *data)
+{
+	struct device *dev = data;
+	int i = cell_index(dev);
+	u8 chip;
+
+	if (i < 0)
+		return NOTIFY_DONE;
+
+	chip = eiois200_cell_chip(dev);
+
+	switch (action) {
+	case BUS_NOTIFY_BIND_DRIVER:
+		cells.bind[chip][i] = ktime_get();
+		break;
+
+	case BUS_NOTIFY_BOUND_DRIVER:
+		dev_info(dev, "Ready in %lldms, %lldms after registration\n",
+			 ktime_ms_delta(ktime_get(), cells.bind[chip][i]),
+			 ktime_ms_delta(ktime_get(), cells.added));
+		break;
+	}
+
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block cell_nb = {
+	.notifier_call = cell_notify,
+};
+
+static void cell_notify_release(void *data)
+{
+	bus_unregister_notifier(&platform_bus_type, &cell_nb);
+}
+
+static int cell_notify_init(struct device *dev)
+{
+	int ret;
+
+	cells.parent = dev;
+
+	ret = bus_register_notifier(&platform_bus_type, &cell_nb);
+	if (ret)
+		return ret;
+
+	return devm_add_action_or_reset(dev, cell_notify_release, NULL);
+}
+
+static int eiois200_probe(struct device *dev, unsigned int id)
+{
+	int  ret = 0;
+	int  i;
+
+	if (sim_chips) {
+		regmap_is200 = sim_regmap_init(dev);
+	} else {
+		iomem = devm_ioport_map(dev, 0, EIOIS200_SUB_PNP_DATA + 1);
+		if (IS_ERR(iomem))
+			return -ENOMEM;
+
+#if KERNEL_VERSION(5, 19, 0) <= LINUX_VERSION_CODE
+		regmap_is200 = devm_regmap_init_mmio(dev, iomem, &pnp_regmap_config);
+#else
+		regmap_is200 = devm_regmap_init(dev, NULL, eiois200_dev, &pnp_regmap_config);
+#endif
+	}
+	if (IS_ERR(regmap_is200))
+		return -ENOMEM;
+
+	eiois200_dev = devm_kzalloc(dev, sizeof(*eiois200_dev), GFP_KERNEL);
+	if (!eiois200_dev)
+		return -ENOMEM;
+
+	mutex_init(&eiois200_dev->mutex);
+	for (i = 0; i < EIOIS200_EC_NUM; i++)
+		mutex_init(&eiois200_dev->pmc_mutex[i]);
+
+	if (eiois200_init(dev)) {
+		dev_dbg(dev, "No device found\n");
+		return -ENODEV;
+	}
+
+	if (firmware_code_base(dev)) {
+		dev_err(dev, "Chip code base check fail\n");
+		return -EIO;
+	}
+
+	pmc_learn_calibrate(dev);
+
+	ret = devm_add_action_or_reset(dev, pmc_cache_release, NULL);
+	if (ret)
+		return ret;
+
+	/* Released before the PMC queues, so pending saves still go out */
+	ret = devm_add_action_or_reset(dev, pmc_save_release, NULL);
+	if (ret)
+		return ret;
+
+	ret = pmc_snapshot_init(dev);
+	if (ret)
+		return ret;
+
+	ret = eiois200_debugfs_init(dev);
+	if (ret)
+		return ret;
+
+	info_init(dev);
+
+	ret = pmc_misc_init(dev);
+	if (ret)
+		return ret;
+
+	dev_set_drvdata(dev, eiois200_dev);
+
+	ret = cell_notify_init(dev);
+	if (ret)
+		return ret;
+
+	cells.added = ktime_get();
+
+	/* Main chip children keep their names, sub chip ones get a .1 suffix */
+	for (i = 0; i < EIOIS200_EC_NUM; i++) {
+		if (!eiois200_chip_exist(eiois200_dev, i))
+			continue;
+
+		ret = devm_mfd_add_devices(dev, i ? i : PLATFORM_DEVID_NONE,
+					   mfd_devs[i], CELL_NUM,
+					   NULL, 0, NULL);
+		if (ret)
+			dev_err(dev, "Cannot register EC%d child devices (error = %d)\n",
+				i, ret);
+	}
+
+	dev_dbg(dev, "Module insert completed\n");
+
+	return 0;
+}
+
+static void eiois200_shutdown(struct device *dev, unsigned int id)
+{
+	eiois200_core_cfg_sync(dev);
+}
+
+static struct isa_driver eiois200_driver = {
+	.probe    = eiois200_probe,
+	.shutdown = eiois200_shutdown,
+
+	.driver = {
+		.name = "eiois200_core",
+		.dev_groups = pmc_groups,
+	},
+};
+module_isa_driver(eiois200_driver, 1);
+
+MODULE_AUTHOR("Wenkai <advantech.susiteam@gmail.com>");
+MODULE_DESCRIPTION("Advantech EIO-IS200 series EC core driver");
+MODULE_LICENSE("GPL v2");
+
+#ifdef EIOIS200_KUNIT
+/* Hooks for eiois200_core_test, see eiois200_kunit.h */
+struct eiois200_dev *eiois200_kunit_core(void)
+{
+	return eiois200_dev;
+}
+EXPORT_SYMBOL_GPL(eiois200_kunit_core);
+
+void eiois200_kunit_stat(int chip, struct eiois200_kunit_stat *stat)
+{
+	struct pmc_chip *pmc = &pmc_chip[chip];
+	int i;
+
+	memset(stat, 0, sizeof(*stat));
+
+	spin_lock(&pmc_cache_lock);
+	stat->cache_hit = cstat.hit;
+	spin_unlock(&pmc_cache_lock);
+
+	if (eiois200_dev) {
+		mutex_lock(&eiois200_dev->mutex);
+		stat->pnp_enter = pnp_cache[chip].enter;
+		mutex_unlock(&eiois200_dev->mutex);
+	}
+
+	spin_lock(&pmc->lock);
+	stat->depth	     = pmc->qstat[PMC_PRIO_INTERACTIVE].depth;
+	stat->coalesced	     = pmc->qstat[PMC_PRIO_INTERACTIVE].coalesced;
+	stat->budget_count   = pmc->bstat.count;
+	stat->budget_used_us = pmc->bstat.used_us;
+	spin_unlock(&pmc->lock);
+
+	stat->save_cmds =
+		atomic64_read(&pmc_stat[chip].cmd[EIOIS200_PMC_CMD_CFG_SAVE].count);
+	stat->saved = atomic64_read(&cfg_save.saved);
+	stat->dirty = test_bit(chip, &cfg_save.dirty);
+
+	for (i = 0; i < EIOIS200_CLIENT_NUM; i++) {
+		stat->client_count[i] = atomic64_read(&pmc_client[i].count);
+		stat->client_throttled[i] =
+			atomic64_read(&pmc_client[i].throttled);
+	}
+}
+EXPORT_SYMBOL_GPL(eiois200_kunit_stat);
+
+/* Like writing client_rate, but always starts with a full bucket */
+void eiois200_kunit_client_rate(u8 client, uint rate)
+{
+	spin_lock(&client_lock);
+	WRITE_ONCE(client_rate[client], rate);
+	pmc_client[client].rate = 0;
+	spin_unlock(&client_lock);
+}
+EXPORT_SYMBOL_GPL(eiois200_kunit_client_rate);
+
+int eiois200_kunit_acpiram_read(struct device *dev, u8 offset,
+				u8 *buf, uint len)
+{
+	return acpiram_read(dev, offset, buf, len);
+}
+EXPORT_SYMBOL_GPL(eiois200_kunit_acpiram_read);
+
+/* The chip lock is held for the PMC port hooks */
+void eiois200_kunit_pmc_stray(int chip, u8 val)
+{
+	pmc_io_write(chip, PMC_IO_DATA, val);
+}
+EXPORT_SYMBOL_GPL(eiois200_kunit_pmc_stray);
+
+bool eiois200_kunit_sim_stray(int chip)
+{
+	return sim_stray(chip);
+}
+EXPORT_SYMBOL_GPL(eiois200_kunit_sim_stray);
+
+void eiois200_kunit_pmc_clear(struct device *dev, int chip)
+{
+	pmc_clear(dev, chip);
+}
+EXPORT_SYMBOL_GPL(eiois200_kunit_pmc_clear);
+
+void eiois200_kunit_learn_get(int chip, struct eiois200_kunit_learn *learn)
+{
+	struct pmc_chip *pmc = &pmc_chip[chip];
+
+	learn->srtt	  = pmc->srtt;
+	learn->rttvar	  = pmc->rttvar;
+	learn->spin_us	  = pmc->spin_us;
+	learn->poll_us	  = pmc->poll_us;
+	learn->timeout_us = pmc->timeout_us;
+}
+EXPORT_SYMBOL_GPL(eiois200_kunit_learn_get);
+
+void eiois200_kunit_learn_set(int chip,
+			      const struct eiois200_kunit_learn *learn)
+{
+	struct pmc_chip *pmc = &pmc_chip[chip];
+
+	pmc->srtt   = learn->srtt;
+	pmc->rttvar = learn->rttvar;
+	WRITE_ONCE(pmc->spin_us, learn->spin_us);
+	WRITE_ONCE(pmc->poll_us, learn->poll_us);
+	WRITE_ONCE(pmc->timeout_us, learn->timeout_us);
+}
+EXPORT_SYMBOL_GPL(eiois200_kunit_learn_set);
+#endif
@@ -0,0 +1,509 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit tests of the Advantech EIO-IS200 Series EC base Driver, built as
+ * the eiois200_core_test module with make KUNIT=y.
+ *
+ * The suite runs against the probed core on the software EC model, so the
+ * core must be built with KUNIT=y SIM=y and loaded with simulate=1 first.
+ * It goes through the exported API like a sub-driver and never replaces or
+ * resets the state of the core. On real hardware, or without the core,
+ * every case is skipped.
+ *
+ * The timing cases print transactions per second and the average chip lock
+ * hold time, as a baseline for performance changes of the core.
+ *
+ * The eiois200_pmc suite only checks the payload sizes of the header and
+ * always runs.
+ *
+ * Copyright (C) 2023 Advantech Co., Ltd.
+ */
+
+#include <linux/delay.h>
+#include <linux/device.h>
+#include <linux/math64.h>
+#include <linux/module.h>
+#include <linux/string.h>
+#include <linux/mfd/eiois200.h>
+#include <kunit/test.h>
+
+#include "eiois200_kunit.h"
+
+#define TEST_LOOPS	100
+#define TEST_TIMEOUT	200	/* Shortest timeout the core accepts */
+#define TEST_POLL	1000	/* Times 100us for the worker to pick a request */
+#define TEST_DATA	32	/* Largest value of the model */
+#define SIM_NAME	"EIO-SIM"
+
+static struct device *test_dev;
+static struct eiois200_dev *test_core;
+static bool test_sim;
+
+static void eiois200_test_exit(struct kunit_suite *suite)
+{
+	root_device_unregister(test_dev);
+	test_core = NULL;
+}
+
+static int eiois200_test_init(struct kunit_suite *suite)
+{
+	char name[16] = "";
+	struct pmc_op op = {
+		.cmd	 = 0x53,
+		.control = 0x10,
+		.payload = (u8 *)name,
+		.size	 = sizeof(name) - 1,
+	};
+
+	test_dev = root_device_register("eiois200_test");
+	if (IS_ERR(test_dev))
+		return PTR_ERR(test_dev);
+
+	/* Only touch a core running on the model */
+	test_core = eiois200_kunit_core();
+	test_sim  = test_core &&
+		    !eiois200_core_pmc_operation(test_dev, &op) &&
+		    !strcmp(name, SIM_NAME);
+
+	return 0;
+}
+
+static int eiois200_test_case_init(struct kunit *test)
+{
+	if (!test_sim)
+		kunit_skip(test, "eiois200_core is not loaded with simulate=1");
+
+	return 0;
+}
+
+static void test_read(struct kunit *test)
+{
+	char name[16] = "";
+	struct pmc_op op = {
+		.cmd	 = 0x53,
+		.control = 0x10,
+		.payload = (u8 *)name,
+		.size	 = sizeof(name),
+	};
+
+	KUNIT_ASSERT_EQ(test, eiois200_core_pmc_operation(test_dev, &op), 0);
+	KUNIT_EXPECT_STREQ(test, name, SIM_NAME);
+}
+
+static void test_write_read(struct kunit *test)
+{
+	u8 duty = 42, val = 0;
+	struct pmc_op op = {
+		.cmd	 = 0x20,
+		.control = 0x14,
+		.payload = &duty,
+		.size	 = sizeof(duty),
+	};
+
+	KUNIT_ASSERT_EQ(test, eiois200_core_pmc_operation(test_dev, &op), 0);
+
+	op.cmd	   = 0x21;
+	op.payload = &val;
+	KUNIT_ASSERT_EQ(test, eiois200_core_pmc_operation(test_dev, &op), 0);
+	KUNIT_EXPECT_EQ(test, val, 42);
+}
+
+static void test_typed(struct kunit *test)
+{
+	u8 val = 0;
+	struct pmc_op op = { .cmd = 0x20, .control = 0x14 };
+
+	KUNIT_ASSERT_EQ(test, eiois200_pmc_write(test_dev, &op, (u8)24), 0);
+
+	op.cmd = 0x21;
+	KUNIT_ASSERT_EQ(test, eiois200_pmc_read(test_dev, &op, &val), 0);
+	KUNIT_EXPECT_EQ(test, val, 24);
+}
+
+static void test_cfg_save(struct kunit *test)
+{
+	struct eiois200_kunit_stat before, after;
+	struct pmc_op op = { .cmd = 0x20, .control = 0x14, .persist = true };
+
+	eiois200_kunit_stat(0, &before);
+
+	KUNIT_ASSERT_EQ(test, eiois200_pmc_write(test_dev, &op, (u8)10), 0);
+	KUNIT_ASSERT_EQ(test, eiois200_pmc_write(test_dev, &op, (u8)20), 0);
+
+	eiois200_kunit_stat(0, &after);
+	KUNIT_EXPECT_TRUE(test, after.dirty);
+
+	/* Both writes go out with a single save */
+	KUNIT_ASSERT_EQ(test, eiois200_core_cfg_sync(test_dev), 0);
+
+	eiois200_kunit_stat(0, &after);
+	KUNIT_EXPECT_FALSE(test, after.dirty);
+	KUNIT_EXPECT_EQ(test, after.saved, before.saved + 1);
+	KUNIT_EXPECT_EQ(test, after.save_cmds, before.save_cmds + 1);
+}
+
+static void test_client_rate(struct kunit *test)
+{
+	const u8 client = EIOIS200_CLIENT_HWMON;
+	struct eiois200_kunit_stat before, after;
+	u8 val, vals[3];
+	int status[3];
+	struct pmc_op op = {
+		.cmd	 = 0x21,
+		.control = 0x14,
+		.client	 = client,
+	};
+	struct pmc_op ops[3];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(ops); i++) {
+		ops[i] = op;
+		ops[i].size    = 1;
+		ops[i].payload = &vals[i];
+	}
+
+	eiois200_kunit_stat(0, &before);
+	eiois200_kunit_client_rate(client, 2);
+
+	/* Every command of a batch costs a token */
+	KUNIT_EXPECT_EQ(test, eiois200_core_pmc_batch(test_dev, ops, 3, status),
+			-EBUSY);
+	KUNIT_EXPECT_EQ(test, status[2], -EBUSY);
+
+	/* A full bucket of two, then the client is throttled */
+	KUNIT_EXPECT_EQ(test, eiois200_pmc_read(test_dev, &op, &val), 0);
+	KUNIT_EXPECT_EQ(test, eiois200_pmc_read(test_dev, &op, &val), 0);
+	KUNIT_EXPECT_EQ(test, eiois200_pmc_read(test_dev, &op, &val), -EBUSY);
+
+	/* Other clients are not affected */
+	op.client = EIOIS200_CLIENT_WDT;
+	KUNIT_EXPECT_EQ(test, eiois200_pmc_read(test_dev, &op, &val), 0);
+
+	eiois200_kunit_client_rate(client, 0);
+	eiois200_kunit_stat(0, &after);
+
+	KUNIT_EXPECT_EQ(test, after.client_count[client],
+			before.client_count[client] + 2);
+	KUNIT_EXPECT_EQ(test, after.client_throttled[client],
+			before.client_throttled[client] + 2);
+}
+
+static void test_batch(struct kunit *test)
+{
+	u32 boot = 0, hour = ~0;
+	int status[2] = { -1, -1 };
+	struct pmc_op ops[] = {
+		{ .cmd = 0x55, .control = 0x10, .payload = (u8 *)&boot, .size = 4 },
+		{ .cmd = 0x55, .control = 0x11, .payload = (u8 *)&hour, .size = 4 },
+	};
+
+	KUNIT_ASSERT_EQ(test, eiois200_core_pmc_batch(test_dev, ops, 2, status), 0);
+	KUNIT_EXPECT_EQ(test, status[0], 0);
+	KUNIT_EXPECT_EQ(test, status[1], 0);
+	KUNIT_EXPECT_EQ(test, boot, 1);
+	KUNIT_EXPECT_EQ(test, hour, 0);
+}
+
+static void test_batch_other_chip(struct kunit *test)
+{
+	u8 val;
+	struct pmc_op op = {
+		.cmd	 = 0x53,
+		.control = 0x10,
+		.payload = &val,
+		.size	 = 1,
+		.chip	 = 1,
+	};
+
+	if (eiois200_chip_exist(test_core, 1))
+		kunit_skip(test, "the sub chip is simulated too");
+
+	KUNIT_EXPECT_EQ(test, eiois200_core_pmc_batch(test_dev, &op, 1, NULL),
+			-ENODEV);
+}
+
+static void test_wait(struct kunit *test)
+{
+	struct eiois200_kunit_learn learn;
+
+	mutex_lock(&test_core->pmc_mutex[0]);
+
+	/* The forced timeout below backs off the learned timeout */
+	eiois200_kunit_learn_get(0, &learn);
+
+	/* Idle EC: input buffer empty, output buffer never fills */
+	KUNIT_EXPECT_EQ(test, WAIT_IBF(test_dev, 0, TEST_TIMEOUT), 0);
+	KUNIT_EXPECT_NE(test, WAIT_OBF(test_dev, 0, TEST_TIMEOUT), 0);
+
+	/* Out of range timeout */
+	KUNIT_EXPECT_EQ(test, WAIT_IBF(test_dev, 0, TEST_TIMEOUT - 1), -ETIME);
+
+	eiois200_kunit_learn_set(0, &learn);
+
+	mutex_unlock(&test_core->pmc_mutex[0]);
+}
+
+static void test_clear(struct kunit *test)
+{
+	mutex_lock(&test_core->pmc_mutex[0]);
+
+	/* A byte outside a command holds IBF until pmc_clear() drains it */
+	eiois200_kunit_pmc_stray(0, 0x00);
+	KUNIT_EXPECT_TRUE(test, eiois200_kunit_sim_stray(0));
+
+	eiois200_kunit_pmc_clear(test_dev, 0);
+	KUNIT_EXPECT_FALSE(test, eiois200_kunit_sim_stray(0));
+	KUNIT_EXPECT_EQ(test, WAIT_IBF(test_dev, 0, TEST_TIMEOUT), 0);
+
+	mutex_unlock(&test_core->pmc_mutex[0]);
+}
+
+static void test_pnp_cache(struct kunit *test)
+{
+	struct eiois200_kunit_stat before, after;
+	struct pnp_op ops[] = {
+		{ .ldn = EIOIS200_LDN_PMC1, .reg = EIOIS200_IOBA0H },
+		{ .ldn = EIOIS200_LDN_PMC1, .reg = EIOIS200_IOBA0L },
+	};
+
+	eiois200_kunit_stat(0, &before);
+
+	/* Read at probe, served without entering the configuration space */
+	KUNIT_ASSERT_EQ(test, eiois200_core_pnp_batch(test_dev, 0, ops, 2), 0);
+	KUNIT_EXPECT_EQ(test, (ops[0].val << 8) | ops[1].val,
+			test_core->pmc[0].data);
+	eiois200_kunit_stat(0, &after);
+	KUNIT_EXPECT_EQ(test, after.pnp_enter, before.pnp_enter);
+
+	/* Writes reach the hardware and update the cache */
+	ops[0] = (struct pnp_op) { .ldn = 0x0F, .reg = EIOIS200_IRQCTRL,
+				   .val = 5, .write = true };
+	KUNIT_ASSERT_EQ(test, eiois200_core_pnp_batch(test_dev, 0, ops, 1), 0);
+	eiois200_kunit_stat(0, &after);
+	KUNIT_EXPECT_EQ(test, after.pnp_enter, before.pnp_enter + 1);
+
+	ops[0].write = false;
+	ops[0].val = 0;
+	KUNIT_ASSERT_EQ(test, eiois200_core_pnp_batch(test_dev, 0, ops, 1), 0);
+	KUNIT_EXPECT_EQ(test, ops[0].val, 5);
+	eiois200_kunit_stat(0, &after);
+	KUNIT_EXPECT_EQ(test, after.pnp_enter, before.pnp_enter + 1);
+}
+
+static void test_acpiram(struct kunit *test)
+{
+	u8 val = 0;
+
+	KUNIT_ASSERT_EQ(test, eiois200_kunit_acpiram_read(test_dev,
+							  EIOIS200_ACPIRAM_ICVENDOR,
+							  &val, 1), 0);
+	KUNIT_EXPECT_EQ(test, val, 'R');
+
+	KUNIT_ASSERT_EQ(test, eiois200_kunit_acpiram_read(test_dev,
+							  EIOIS200_ACPIRAM_ICCODE,
+							  &val, 1), 0);
+	KUNIT_EXPECT_EQ(test, val, EIOIS200_ICCODE);
+}
+
+static void test_acpiram_bulk(struct kunit *test)
+{
+	u8 buf[256];
+
+	KUNIT_ASSERT_EQ(test, eiois200_kunit_acpiram_read(test_dev, 0, buf,
+							  sizeof(buf)), 0);
+	KUNIT_EXPECT_EQ(test, buf[EIOIS200_ACPIRAM_ICVENDOR], 'R');
+	KUNIT_EXPECT_EQ(test, buf[EIOIS200_ACPIRAM_ICCODE], EIOIS200_ICCODE);
+	KUNIT_EXPECT_EQ(test, buf[EIOIS200_ACPIRAM_CODEBASE],
+			EIOIS200_ACPIRAM_CODEBASE_NEW);
+
+	KUNIT_EXPECT_EQ(test, eiois200_kunit_acpiram_read(test_dev, 0xFF, buf, 2),
+			-EINVAL);
+}
+
+static void test_cache(struct kunit *test)
+{
+	struct eiois200_kunit_stat before, after;
+	u32 val;
+	struct pmc_op op = {
+		.cmd	 = 0x53,
+		.control = 0x21,
+		.payload = (u8 *)&val,
+		.size	 = sizeof(val),
+		.ttl	 = 1000,
+	};
+
+	/* A write to the same value drops the cached read */
+	op.cmd = 0x52;
+	val = 0x01000000;
+	KUNIT_ASSERT_EQ(test, eiois200_core_pmc_operation(test_dev, &op), 0);
+
+	op.cmd = 0x53;
+	eiois200_kunit_stat(0, &before);
+	KUNIT_ASSERT_EQ(test, eiois200_core_pmc_operation(test_dev, &op), 0);
+	KUNIT_ASSERT_EQ(test, eiois200_core_pmc_operation(test_dev, &op), 0);
+	eiois200_kunit_stat(0, &after);
+
+	KUNIT_EXPECT_EQ(test, val, 0x01000000);
+	KUNIT_EXPECT_EQ(test, after.cache_hit, before.cache_hit + 1);
+}
+
+static void test_coalesce(struct kunit *test)
+{
+	struct eiois200_kunit_stat before, stat;
+	u32 val[3] = { 0 };
+	struct pmc_op ops[3];
+	struct pmc_request req[3];
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		ops[i] = (struct pmc_op) {
+			.cmd	 = 0x53,
+			.control = 0x21,
+			.payload = (u8 *)&val[i],
+			.size	 = sizeof(val[i]),
+		};
+		req[i] = (struct pmc_request) {
+			.ops	  = &ops[i],
+			.num	  = 1,
+			.priority = PMC_PRIO_INTERACTIVE,
+		};
+	}
+
+	eiois200_kunit_stat(0, &before);
+
+	/*
+	 * Stall the worker on the first request. Once it has taken it off
+	 * the queue, the second one stays queued and the third joins it.
+	 */
+	mutex_lock(&test_core->pmc_mutex[0]);
+
+	KUNIT_ASSERT_EQ(test, eiois200_core_pmc_submit(test_dev, &req[0]), 0);
+	for (i = 0; i < TEST_POLL; i++) {
+		eiois200_kunit_stat(0, &stat);
+		if (!stat.depth)
+			break;
+		usleep_range(100, 200);
+	}
+
+	if (stat.depth) {
+		mutex_unlock(&test_core->pmc_mutex[0]);
+		wait_for_completion(&req[0].done);
+		KUNIT_FAIL(test, "the worker did not pick up the request");
+		return;
+	}
+
+	KUNIT_EXPECT_EQ(test, eiois200_core_pmc_submit(test_dev, &req[1]), 0);
+	KUNIT_EXPECT_EQ(test, eiois200_core_pmc_submit(test_dev, &req[2]), 0);
+
+	mutex_unlock(&test_core->pmc_mutex[0]);
+
+	for (i = 0; i < 3; i++) {
+		wait_for_completion(&req[i].done);
+		KUNIT_EXPECT_EQ(test, req[i].result, 0);
+		KUNIT_EXPECT_EQ(test, val[i], 0x01000000);
+	}
+
+	eiois200_kunit_stat(0, &stat);
+	KUNIT_EXPECT_EQ(test, stat.coalesced, before.coalesced + 1);
+}
+
+static void test_perf(struct kunit *test, u8 size)
+{
+	struct eiois200_kunit_stat before, after;
+	u8 data[TEST_DATA];
+	struct pmc_op op = {
+		.cmd	 = 0x53,
+		.control = 0x23,
+		.payload = data,
+		.size	 = size,
+	};
+	u64 count, used;
+	ktime_t start;
+	s64 ns;
+	int i;
+
+	eiois200_kunit_stat(0, &before);
+
+	start = ktime_get();
+	for (i = 0; i < TEST_LOOPS; i++)
+		KUNIT_ASSERT_EQ(test, eiois200_core_pmc_operation(test_dev, &op), 0);
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	eiois200_kunit_stat(0, &after);
+	count = after.budget_count - before.budget_count;
+	used  = after.budget_used_us - before.budget_used_us;
+
+	kunit_info(test, "%u byte read: %llu transactions/s, lock hold %llu us avg\n",
+		   size, div64_u64((u64)TEST_LOOPS * NSEC_PER_SEC, max_t(s64, ns, 1)),
+		   count ? div64_u64(used, count) : 0);
+}
+
+static void test_perf_small(struct kunit *test)
+{
+	test_perf(test, 4);
+}
+
+static void test_perf_large(struct kunit *test)
+{
+	test_perf(test, 26);
+}
+
+static struct kunit_case eiois200_test_cases[] = {
+	KUNIT_CASE(test_read),
+	KUNIT_CASE(test_write_read),
+	KUNIT_CASE(test_typed),
+	KUNIT_CASE(test_cfg_save),
+	KUNIT_CASE(test_client_rate),
+	KUNIT_CASE(test_batch),
+	KUNIT_CASE(test_batch_other_chip),
+	KUNIT_CASE(test_wait),
+	KUNIT_CASE(test_clear),
+	KUNIT_CASE(test_pnp_cache),
+	KUNIT_CASE(test_acpiram),
+	KUNIT_CASE(test_acpiram_bulk),
+	KUNIT_CASE(test_cache),
+	KUNIT_CASE(test_coalesce),
+	KUNIT_CASE(test_perf_small),
+	KUNIT_CASE(test_perf_large),
+	{}
+};
+
+static struct kunit_suite eiois200_test_suite = {
+	.name	    = "eiois200_core",
+	.suite_init = eiois200_test_init,
+	.suite_exit = eiois200_test_exit,
+	.init	    = eiois200_test_case_init,
+	.test_cases = eiois200_test_cases,
+};
+
+/*
+ * The sub-drivers size their batch operations by the type of the value,
+ * where they used to keep per-control size tables. Needs no core.
+ */
+static void test_pmc_size(struct kunit *test)
+{
+	u8 v8;
+	u16 v16;
+	u32 v32;
+	struct pmc_op op = { .size = EIOIS200_PMC_SIZE(&v16) };
+
+	KUNIT_EXPECT_EQ(test, EIOIS200_PMC_SIZE(&v8), 1);
+	KUNIT_EXPECT_EQ(test, EIOIS200_PMC_SIZE(&v16), 2);
+	KUNIT_EXPECT_EQ(test, EIOIS200_PMC_SIZE(&v32), 4);
+	KUNIT_EXPECT_EQ(test, op.size, 2);
+}
+
+static struct kunit_case eiois200_pmc_test_cases[] = {
+	KUNIT_CASE(test_pmc_size),
+	{}
+};
+
+static struct kunit_suite eiois200_pmc_test_suite = {
+	.name	    = "eiois200_pmc",
+	.test_cases = eiois200_pmc_test_cases,
+};
+
+kunit_test_suites(&eiois200_test_suite, &eiois200_pmc_test_suite);
+
+MODULE_AUTHOR("Wenkai <advantech.susiteam@gmail.com>");
+MODULE_DESCRIPTION("KUnit tests of the Advantech EIO-IS200 core driver");
+MODULE_LICENSE("GPL v2");
@@ -0,0 +1,56 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Hooks of eiois200_core for the eiois200_core_test KUnit module.
+ *
+ * They are only built and exported with make KUNIT=y. The test module
+ * drives the probed core through its regular API and uses these to look
+ * at counters the API does not report.
+ *
+ * Copyright (C) 2023 Advantech Co., Ltd.
+ */
+
+#ifndef _EIOIS200_KUNIT_H_
+#define _EIOIS200_KUNIT_H_
+
+#include <linux/device.h>
+#include <linux/mfd/eiois200.h>
+
+/* Counters of one chip, see the debugfs files of the same names */
+struct eiois200_kunit_stat {
+	u64 cache_hit;		/* cache, shared by both chips */
+	u64 pnp_enter;		/* pnp */
+	u32 depth;		/* queue, interactive */
+	u64 coalesced;		/* queue, interactive */
+	u64 budget_count;	/* budget */
+	u64 budget_used_us;	/* budget */
+	u64 save_cmds;		/* stats, CFG_SAVE commands sent */
+	u64 saved;		/* save */
+	bool dirty;		/* save, this chip */
+	u64 client_count[EIOIS200_CLIENT_NUM];		/* clients */
+	u64 client_throttled[EIOIS200_CLIENT_NUM];	/* clients */
+};
+
+/* Learned EC timing of one chip, see pmc_learn_update() */
+struct eiois200_kunit_learn {
+	u32 srtt;
+	u32 rttvar;
+	u32 spin_us;
+	u32 poll_us;
+	u32 timeout_us;
+};
+
+struct eiois200_dev *eiois200_kunit_core(void);
+void eiois200_kunit_stat(int chip, struct eiois200_kunit_stat *stat);
+void eiois200_kunit_client_rate(u8 client, uint rate);
+int eiois200_kunit_acpiram_read(struct device *dev, u8 offset,
+				u8 *buf, uint len);
+
+/* Called with the pmc_mutex of @chip held */
+void eiois200_kunit_pmc_stray(int chip, u8 val);
+bool eiois200_kunit_sim_stray(int chip);
+void eiois200_kunit_pmc_clear(struct device *dev, int chip);
+void eiois200_kunit_learn_get(int chip, struct eiois200_kunit_learn *learn);
+void eiois200_kunit_learn_set(int chip,
+			      const struct eiois200_kunit_learn *learn);
+
+#endif
@@ -0,0 +1,455 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Software model of the EIO-IS200 for eiois200_core, linked into the
+ * module with make SIM=y.
+ *
+ * Loading the core with simulate=1 (or 2 for a sub chip too) replaces the
+ * I/O port regmap with this model, so the core and all sub-drivers run on
+ * a machine without the EC:
+ *
+ * - PNP index/data protocol: 0x87 0x87 unlock, 0xAA lock, LDN select,
+ *   chip id and IOBA registers.
+ * - PMC handshake: IBF stays set and OBF stays clear for sim_latency usec
+ *   after every byte. A data byte outside a command keeps IBF set until
+ *   the data port is read, as pmc_clear() expects.
+ * - A table of PMC values for board information, hwmon, thermal, fan,
+ *   GPIO, watchdog and backlight. Writes update the table.
+ * - One I2C controller without slaves, every address is NAKed.
+ *
+ * Copyright (C) 2023 Advantech Co., Ltd.
+ */
+
+#include <linux/device.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/regmap.h>
+#include <linux/slab.h>
+#include <linux/mfd/eiois200.h>
+
+#include "eiois200_sim.h"
+
+#define SIM_PMC_DATA(id)	(0x2F2 + (id) * 8)
+#define SIM_PMC_CMD(id)		(SIM_PMC_DATA(id) + 4)
+#define SIM_I2C_BASE		0x2C0
+#define SIM_I2C_SIZE		0x10
+#define SIM_DATA		32
+#define SIM_LDN_NUM		ARRAY_SIZE(sim_ldns)
+
+/* Read-only I2C controller registers, see i2c-eiois200.c */
+#define SIM_I2C_STAT		0x01
+#define SIM_I2C_STAT_TXDONE	BIT(5)
+#define SIM_I2C_STAT_NAK_ERR	BIT(4)
+#define SIM_I2C_ECTRL		0x07
+#define SIM_I2C_SEM		0x08
+
+/**
+ * simulate: Number of simulated chips. 0 drives the real hardware.
+ */
+uint sim_chips;
+module_param_named(simulate, sim_chips, uint, 0444);
+MODULE_PARM_DESC(simulate,
+		 "Number of simulated chips instead of the hardware, 0 to disable.\n");
+
+static uint sim_latency = 20;
+module_param(sim_latency, uint, 0644);
+MODULE_PARM_DESC(sim_latency, "Simulated EC latency per PMC byte in usec.\n");
+
+static const struct {
+	u16 idx_port;
+	u16 data_port;
+} sim_pnp[] = {
+	{ EIOIS200_PNP_INDEX,	  EIOIS200_PNP_DATA	},
+	{ EIOIS200_SUB_PNP_INDEX, EIOIS200_SUB_PNP_DATA },
+};
+
+struct sim_reg {
+	u8 cmd;	/* Write command, the read command is cmd | 1 */
+	u8 ctrl;
+	u8 id;
+	u8 data[SIM_DATA];
+};
+
+#define SIM_VAL(_cmd, _ctrl, _id, _val) \
+	{ _cmd, _ctrl, _id, { (_val) & 0xFF, (_val) >> 8 & 0xFF, \
+			      (_val) >> 16 & 0xFF, (_val) >> 24 & 0xFF } }
+#define SIM_STR(_cmd, _ctrl, _id, _str) { _cmd, _ctrl, _id, _str }
+
+static const struct sim_reg sim_model[] = {
+	/* Board information */
+	SIM_STR(0x52, 0x10, 0x00, "EIO-SIM"),
+	SIM_STR(0x52, 0x1F, 0x00, "SIM0000001"),
+	SIM_STR(0x52, 0x11, 0x00, "Advantech"),
+	SIM_VAL(0x52, 0x1E, 0x00, 0x00000001),
+	SIM_VAL(0x52, 0x21, 0x00, 0x01000000),
+	SIM_STR(0x52, 0x22, 0x00, "EIO-IS200 SIM"),
+	SIM_STR(0x52, 0x23, 0x00, "simulator"),
+	SIM_STR(0x52, 0x24, 0x00, "2023/01/01"),
+	SIM_STR(0x52, 0x12, 0x00, "EIO-IS200"),
+	SIM_STR(0x52, 0x15, 0x00, "EIO-IS200"),
+	SIM_STR(0x52, 0x13, 0x00, "SIM"),
+	SIM_VAL(0x52, 0x04, 0x44, 0x00010000),
+	SIM_VAL(0x52, 0x04, 0x64, 0x01000000),
+	SIM_VAL(0x52, 0x31, 0x00, 0x00000001),
+	SIM_VAL(0x52, 0x04, 0x68, 0x00000000),
+	SIM_VAL(0x54, 0x10, 0x00, 1),
+	SIM_VAL(0x54, 0x11, 0x00, 0),
+
+	/* Voltage: available, 12V */
+	SIM_VAL(0x12, 0x00, 0x00, 0x01),
+	SIM_VAL(0x12, 0x01, 0x00, 0x00),
+	SIM_VAL(0x12, 0x10, 0x00, 1200),
+	SIM_VAL(0x12, 0x11, 0x00, 1260),
+	SIM_VAL(0x12, 0x12, 0x00, 1140),
+
+	/* Thermal: available with all protections, 0.1 Kelvin */
+	SIM_VAL(0x10, 0x00, 0x00, 0x0F),
+	SIM_VAL(0x10, 0x01, 0x00, 0x00),
+	SIM_VAL(0x10, 0x10, 0x00, 3231),
+	SIM_VAL(0x10, 0x11, 0x00, 3731),
+	SIM_VAL(0x10, 0x12, 0x00, 2731),
+	SIM_VAL(0x10, 0x21, 0x00, 3531),
+	SIM_VAL(0x10, 0x22, 0x00, 3431),
+	SIM_VAL(0x10, 0x31, 0x00, 3731),
+	SIM_VAL(0x10, 0x32, 0x00, 3631),
+	SIM_VAL(0x10, 0x41, 0x00, 3831),
+	SIM_VAL(0x10, 0x42, 0x00, 3731),
+
+	/* Tacho */
+	SIM_VAL(0x16, 0x00, 0x00, 0x01),
+	SIM_VAL(0x16, 0x10, 0x00, 3000),
+
+	/* Fan: auto mode */
+	SIM_VAL(0x24, 0x00, 0x00, 0x01),
+	SIM_STR(0x24, 0x01, 0x00, "CPU"),
+	SIM_VAL(0x24, 0x02, 0x00, 0x03),
+	SIM_VAL(0x24, 0x10, 0x00, 50),
+	SIM_VAL(0x24, 0x13, 0x00, 600),
+	SIM_VAL(0x24, 0x14, 0x00, 400),
+	SIM_VAL(0x24, 0x15, 0x00, 300),
+	SIM_VAL(0x24, 0x16, 0x00, 100),
+	SIM_VAL(0x24, 0x17, 0x00, 30),
+	SIM_VAL(0x24, 0x1A, 0x00, 3000),
+
+	/* GPIO: group 0 pins available */
+	SIM_VAL(0x18, 0x00, 0x00, 0x01),
+	SIM_VAL(0x18, 0x03, 0x00, 0x00FF),
+
+	/* Watchdog: reset, IRQ and power button events, msec */
+	SIM_VAL(0x2A, 0x00, 0x00, 0x98),
+	SIM_VAL(0x2A, 0x12, 0x00, 0),
+	SIM_VAL(0x2A, 0x13, 0x00, 0),
+	SIM_VAL(0x2A, 0x14, 0x00, 60000),
+	SIM_VAL(0x2A, 0x15, 0x00, 0),
+	SIM_VAL(0x2A, 0x16, 0x00, 0),
+
+	/* Backlight */
+	SIM_VAL(0x20, 0x00, 0x00, 0x01),
+	SIM_VAL(0x20, 0x12, 0x00, 0x01),
+	SIM_VAL(0x20, 0x14, 0x00, 80),
+	SIM_VAL(0x20, 0x15, 0x00, 0x00),
+	SIM_VAL(0x20, 0x16, 0x00, 1000),
+};
+
+/* Logical devices with a modelled configuration space */
+static const u8 sim_ldns[] = { EIOIS200_LDN_PMC1, 0x0F, 0x20, 0x21, 0x22, 0x23 };
+
+static struct sim_chip {
+	struct sim_reg *regs;
+	u8 acpiram[256];
+
+	/* PNP configuration */
+	u8 unlock;
+	u8 idx;
+	u8 ldn;
+	u8 cfg[ARRAY_SIZE(sim_ldns)][256];
+
+	/* PMC transaction */
+	u8 in[4 + 255];
+	int in_len;
+	int hdr_len;
+	u8 out[255];
+	int out_len;
+	int out_pos;
+	ktime_t ready;
+	bool stray;	/* Data byte outside a command, holds IBF */
+} sim_chip[EIOIS200_EC_NUM];
+
+static u8 sim_i2c[SIM_I2C_SIZE];
+
+static struct sim_reg *sim_find(struct sim_chip *sim, u8 cmd, u8 ctrl, u8 id)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(sim_model); i++)
+		if (sim->regs[i].cmd == (cmd & ~EIOIS200_FLAG_PMC_READ) &&
+		    sim->regs[i].ctrl == ctrl && sim->regs[i].id == id)
+			return &sim->regs[i];
+
+	return NULL;
+}
+
+/* Header complete, or payload of a write complete */
+static void sim_pmc_exec(struct sim_chip *sim)
+{
+	u8 cmd  = sim->in[0];
+	u8 ctrl = sim->in[1];
+	u8 id   = sim->hdr_len == 4 ? sim->in[2] : 0;
+	u8 size = sim->in[sim->hdr_len - 1];
+	struct sim_reg *reg;
+
+	/* The command is complete, more data bytes are stray */
+	sim->in_len = 0;
+
+	if (cmd == EIOIS200_PMC_CMD_ACPIRAM_READ) {
+		int i;
+
+		for (i = 0; i < size; i++)
+			sim->out[i] = sim->acpiram[(u8)(ctrl + i)];
+		sim->out_len = size;
+		return;
+	}
+
+	reg = sim_find(sim, cmd, ctrl, id);
+
+	if (cmd & EIOIS200_FLAG_PMC_READ) {
+		memset(sim->out, 0, size);
+		if (reg)
+			memcpy(sim->out, reg->data, min_t(int, size, SIM_DATA));
+		sim->out_len = size;
+		return;
+	}
+
+	if (reg)
+		memcpy(reg->data, sim->in + sim->hdr_len,
+		       min_t(int, size, SIM_DATA));
+}
+
+static void sim_pmc_write(struct sim_chip *sim, bool cmd_port, u8 val)
+{
+	sim->ready = ktime_add_us(ktime_get(), sim_latency);
+
+	if (cmd_port) {
+		sim->in[0]   = val;
+		sim->in_len  = 1;
+		sim->hdr_len = val == EIOIS200_PMC_CMD_ACPIRAM_READ ? 3 : 4;
+		sim->out_len = 0;
+		sim->out_pos = 0;
+		return;
+	}
+
+	if (!sim->in_len || sim->in_len >= sizeof(sim->in)) {
+		sim->stray = true;
+		return;
+	}
+
+	sim->in[sim->in_len++] = val;
+
+	if (sim->in_len < sim->hdr_len)
+		return;
+
+	if (sim->in_len == sim->hdr_len) {
+		if ((sim->in[0] & EIOIS200_FLAG_PMC_READ) ||
+		    !sim->in[sim->hdr_len - 1])
+			sim_pmc_exec(sim);
+		return;
+	}
+
+	if (sim->in_len == sim->hdr_len + sim->in[sim->hdr_len - 1])
+		sim_pmc_exec(sim);
+}
+
+static u8 sim_pmc_read(struct sim_chip *sim, bool cmd_port)
+{
+	bool busy = ktime_before(ktime_get(), sim->ready);
+
+	if (cmd_port)
+		return (busy || sim->stray ? EIOIS200_PMC_STATUS_IBF : 0) |
+		       (!busy && sim->out_pos < sim->out_len ?
+			EIOIS200_PMC_STATUS_OBF : 0);
+
+	if (sim->stray) {
+		sim->stray = false;
+		return 0;
+	}
+
+	if (busy || sim->out_pos >= sim->out_len)
+		return 0;
+
+	sim->ready = ktime_add_us(ktime_get(), sim_latency);
+
+	return sim->out[sim->out_pos++];
+}
+
+static u8 *sim_cfg(struct sim_chip *sim)
+{
+	int i;
+
+	for (i = 0; i < SIM_LDN_NUM; i++)
+		if (sim_ldns[i] == sim->ldn)
+			return sim->cfg[i];
+
+	return NULL;
+}
+
+static void sim_pnp_write(struct sim_chip *sim, bool data_port, u8 val)
+{
+	u8 *cfg;
+
+	if (!data_port) {
+		if (val == EIOIS200_EXT_MODE_ENTER && sim->unlock < 2)
+			sim->unlock++;
+		else if (val == EIOIS200_EXT_MODE_EXIT)
+			sim->unlock = 0;
+		else
+			sim->idx = val;
+		return;
+	}
+
+	if (sim->unlock < 2)
+		return;
+
+	if (sim->idx == EIOIS200_LDN) {
+		sim->ldn = val;
+		return;
+	}
+
+	cfg = sim_cfg(sim);
+	if (cfg)
+		cfg[sim->idx] = val;
+}
+
+static u8 sim_pnp_read(struct sim_chip *sim, bool data_port)
+{
+	u8 *cfg;
+
+	if (!data_port || sim->unlock < 2)
+		return 0xFF;
+
+	switch (sim->idx) {
+	case EIOIS200_LDN:
+		return sim->ldn;
+	case EIOIS200_CHIPID1:
+		return EIOIS200_CHIPID >> 8;
+	case EIOIS200_CHIPID2:
+		return EIOIS200_CHIPID & 0xFF;
+	}
+
+	cfg = sim_cfg(sim);
+
+	return cfg ? cfg[sim->idx] : 0xFF;
+}
+
+static u8 sim_i2c_read(uint reg)
+{
+	switch (reg) {
+	case SIM_I2C_STAT:
+		/* Every byte goes out, nobody answers */
+		return SIM_I2C_STAT_TXDONE | SIM_I2C_STAT_NAK_ERR;
+	case SIM_I2C_ECTRL:
+	case SIM_I2C_SEM:
+		return 0;
+	}
+
+	return sim_i2c[reg];
+}
+
+static int sim_reg_read(void *context, unsigned int reg, unsigned int *val)
+{
+	int id;
+
+	*val = 0xFF;
+
+	for (id = 0; id < sim_chips && id < EIOIS200_EC_NUM; id++) {
+		struct sim_chip *sim = &sim_chip[id];
+
+		if (reg == sim_pnp[id].idx_port || reg == sim_pnp[id].data_port)
+			*val = sim_pnp_read(sim, reg == sim_pnp[id].data_port);
+		else if (reg == SIM_PMC_DATA(id) || reg == SIM_PMC_CMD(id))
+			*val = sim_pmc_read(sim, reg == SIM_PMC_CMD(id));
+	}
+
+	if (reg >= SIM_I2C_BASE && reg < SIM_I2C_BASE + SIM_I2C_SIZE)
+		*val = sim_i2c_read(reg - SIM_I2C_BASE);
+
+	return 0;
+}
+
+static int sim_reg_write(void *context, unsigned int reg, unsigned int val)
+{
+	int id;
+
+	for (id = 0; id < sim_chips && id < EIOIS200_EC_NUM; id++) {
+		struct sim_chip *sim = &sim_chip[id];
+
+		if (reg == sim_pnp[id].idx_port || reg == sim_pnp[id].data_port)
+			sim_pnp_write(sim, reg == sim_pnp[id].data_port, val);
+		else if (reg == SIM_PMC_DATA(id) || reg == SIM_PMC_CMD(id))
+			sim_pmc_write(sim, reg == SIM_PMC_CMD(id), val);
+	}
+
+	if (reg >= SIM_I2C_BASE && reg < SIM_I2C_BASE + SIM_I2C_SIZE)
+		sim_i2c[reg - SIM_I2C_BASE] = val;
+
+	return 0;
+}
+
+/* Serialized by the regmap lock, the callbacks never sleep */
+static const struct regmap_config sim_regmap_config = {
+	.name		= "eiois200_sim",
+	.reg_bits	= 16,
+	.val_bits	= 8,
+	.reg_read	= sim_reg_read,
+	.reg_write	= sim_reg_write,
+	.fast_io	= true,
+};
+
+static void sim_set_port(u8 *cfg, u8 hi, u8 lo, u16 port)
+{
+	cfg[hi] = port >> 8;
+	cfg[lo] = port & 0xFF;
+}
+
+/**
+ * sim_regmap_init - Create the simulated I/O port regmap
+ * @dev:	The device structure pointer.
+ */
+struct regmap *sim_regmap_init(struct device *dev)
+{
+	int id;
+
+	for (id = 0; id < sim_chips && id < EIOIS200_EC_NUM; id++) {
+		struct sim_chip *sim = &sim_chip[id];
+
+		sim->regs = devm_kmemdup(dev, sim_model, sizeof(sim_model),
+					 GFP_KERNEL);
+		if (!sim->regs)
+			return ERR_PTR(-ENOMEM);
+
+		sim->acpiram[EIOIS200_ACPIRAM_ICVENDOR] = 'R';
+		sim->acpiram[EIOIS200_ACPIRAM_ICCODE]	= EIOIS200_ICCODE;
+		sim->acpiram[EIOIS200_ACPIRAM_CODEBASE] = EIOIS200_ACPIRAM_CODEBASE_NEW;
+
+		/* PMC1 is the first modelled LDN, I2C0 the third */
+		sim_set_port(sim->cfg[0], EIOIS200_IOBA0H, EIOIS200_IOBA0L,
+			     SIM_PMC_DATA(id));
+		sim_set_port(sim->cfg[0], EIOIS200_IOBA1H, EIOIS200_IOBA1L,
+			     SIM_PMC_CMD(id));
+		if (id == 0)
+			sim_set_port(sim->cfg[2], EIOIS200_IOBA0H,
+				     EIOIS200_IOBA0L, SIM_I2C_BASE);
+	}
+
+	dev_info(dev, "Simulating %u chip(s), %uus per PMC byte\n",
+		 sim_chips, sim_latency);
+
+	return devm_regmap_init(dev, NULL, NULL, &sim_regmap_config);
+}
+
+/**
+ * sim_stray - Check if a stray data byte still holds IBF
+ * @id:		0 for main chip, 1 for sub chip.
+ */
+bool sim_stray(int id)
+{
+	return id < sim_chips && id < EIOIS200_EC_NUM && sim_chip[id].stray;
+}
@@ -0,0 +1,42 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Software model of the EIO-IS200, private to eiois200_core.
+ *
+ * eiois200_sim.c is only linked into the module with make SIM=y. Without
+ * it sim_chips is always 0 and the core drives the hardware.
+ *
+ * Copyright (C) 2023 Advantech Co., Ltd.
+ */
+
+#ifndef _EIOIS200_SIM_H_
+#define _EIOIS200_SIM_H_
+
+#include <linux/device.h>
+#include <linux/err.h>
+#include <linux/regmap.h>
+
+#ifdef EIOIS200_SIM
+
+/* Number of simulated chips, the simulate module parameter */
+extern uint sim_chips;
+
+struct regmap *sim_regmap_init(struct device *dev);
+bool sim_stray(int id);
+
+#else
+
+#define sim_chips	0U
+
+static inline struct regmap *sim_regmap_init(struct device *dev)
+{
+	return ERR_PTR(-ENODEV);
+}
+
+static inline bool sim_stray(int id)
+{
+	return false;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,107 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Trace events of the Advantech EIO-IS200 Series EC base Driver
+ *
+ * Copyright (C) 2023 Advantech Co., Ltd.
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM eiois200
+
+#if !defined(_EIOIS200_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _EIOIS200_TRACE_H
+
+#include <linux/tracepoint.h>
+#include <linux/mfd/eiois200.h>
+
+DECLARE_EVENT_CLASS(eiois200_pmc_op,
+
+	TP_PROTO(const struct pmc_op *op, s64 lock_ns, s64 xfer_ns, int err),
+
+	TP_ARGS(op, lock_ns, xfer_ns, err),
+
+	TP_STRUCT__entry(
+		__field(u8,	chip)
+		__field(u8,	cmd)
+		__field(u8,	control)
+		__field(u8,	device_id)
+		__field(u8,	size)
+		__field(s64,	lock_ns)
+		__field(s64,	xfer_ns)
+		__field(int,	err)
+	),
+
+	TP_fast_assign(
+		__entry->chip	   = op->chip;
+		__entry->cmd	   = op->cmd;
+		__entry->control   = op->control;
+		__entry->device_id = op->device_id;
+		__entry->size	   = op->size;
+		__entry->lock_ns   = lock_ns;
+		__entry->xfer_ns   = xfer_ns;
+		__entry->err	   = err;
+	),
+
+	TP_printk("chip=%u cmd=0x%02x ctrl=0x%02x id=0x%02x size=%u lock_wait=%lldns xfer=%lldns err=%d",
+		  __entry->chip, __entry->cmd, __entry->control,
+		  __entry->device_id, __entry->size,
+		  __entry->lock_ns, __entry->xfer_ns, __entry->err)
+);
+
+/*
+ * Command about to be sent. lock_ns is the time since submission for the
+ * first command of a request, since the end of the previous one otherwise.
+ */
+DEFINE_EVENT(eiois200_pmc_op, eiois200_pmc_start,
+	TP_PROTO(const struct pmc_op *op, s64 lock_ns, s64 xfer_ns, int err),
+	TP_ARGS(op, lock_ns, xfer_ns, err)
+);
+
+/* Command done, xfer_ns is the time spent on the ports */
+DEFINE_EVENT(eiois200_pmc_op, eiois200_pmc_end,
+	TP_PROTO(const struct pmc_op *op, s64 lock_ns, s64 xfer_ns, int err),
+	TP_ARGS(op, lock_ns, xfer_ns, err)
+);
+
+/* Command gave up waiting for the EC */
+DEFINE_EVENT(eiois200_pmc_op, eiois200_pmc_timeout,
+	TP_PROTO(const struct pmc_op *op, s64 lock_ns, s64 xfer_ns, int err),
+	TP_ARGS(op, lock_ns, xfer_ns, err)
+);
+
+TRACE_EVENT(eiois200_pmc_wait,
+
+	TP_PROTO(int chip, int wait, uint limit_us, s64 wait_ns, int err),
+
+	TP_ARGS(chip, wait, limit_us, wait_ns, err),
+
+	TP_STRUCT__entry(
+		__field(int,	chip)
+		__field(int,	wait)
+		__field(uint,	limit_us)
+		__field(s64,	wait_ns)
+		__field(int,	err)
+	),
+
+	TP_fast_assign(
+		__entry->chip	  = chip;
+		__entry->wait	  = wait;
+		__entry->limit_us = limit_us;
+		__entry->wait_ns  = wait_ns;
+		__entry->err	  = err;
+	),
+
+	TP_printk("chip=%d %s limit=%uus wait=%lldns err=%d",
+		  __entry->chip,
+		  __entry->wait == PMC_WAIT_INPUT ? "ibf" : "obf",
+		  __entry->limit_us, __entry->wait_ns, __entry->err)
+);
+
+#endif /* _EIOIS200_TRACE_H */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE eiois200_trace
+
+#include <trace/define_trace.h>
@@ -87,12 +87,18 @@
 #define DUTY_MAX		100
 #define UNIT_PER_TEMP		10
 #define NAME_SIZE		4
+#define CACHE_TTL		60000 /* millisecond */
 
 #define TRIP_HIGH		0
 #define TRIP_LOW		1
 #define TRIP_STOP		2
 #define TRIP_NUM		3
 
+/* Zone data: EC index and fan on that EC */
+#define ZONE_DATA(ec, fan)	((((long)(ec)) << 16) | (fan))
+#define ZONE_EC(val)		(((long)(val)) >> 16)
+#define ZONE_CH(val)		(((long)(val)) & 0xFF)
+
 #define FAN_SRC(val)		((long)(val) >> 4)
 #define FAN_ID(val)		(((long)(val)) >> 8)
 #define FAN_TRIP(val)		(((long)(val)) & 0x0F)
@@ -105,18 +111,41 @@
 #define MILLICELSIUS_TO_DECI_KELVIN(t)	((t) / 100 + 2731)
 #endif
 
-#define FAN_WRITE(dev, ctl, id, data) \
-	pmc_cmd(dev, CMD_FAN_WRITE, ctl, id, pmc_len[ctl], data)
-
-#define FAN_READ(dev, ctl, id, data) \
-	pmc_cmd(dev, CMD_FAN_READ, ctl, id, pmc_len[ctl], data)
-
-static u8 pmc_len[CTRL_THERM_SRC + 1] = {
-/*      0, 1, 2, 3, 4, 5, 6, 7, 8, 9, a, b, c, d, e, f */
-	1, 1, 1, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	1, 1, 4, 2, 2, 2, 1, 1, 2, 2, 2, 0, 0, 0, 0, 0,
-	1,
-};
+/* Target of a typed accessor, the payload size comes from the value type */
+#define FAN_OP(_cmd, ctl, id, _ttl) (&(const struct pmc_op) {	\
+	.cmd       = _cmd,				\
+	.control   = ctl,				\
+	.device_id = ZONE_CH(id),			\
+	.chip	   = ZONE_EC(id),			\
+	.timeout   = timeout,				\
+	.ttl	   = _ttl,				\
+	.persist   = (_cmd) == CMD_FAN_WRITE &&	\
+		     (ctl) != CTRL_VALUE,		\
+	.client	   = EIOIS200_CLIENT_FAN,		\
+})
+
+#define FAN_WRITE(dev, ctl, id, val) \
+	eiois200_pmc_write(dev, FAN_OP(CMD_FAN_WRITE, ctl, id, 0), val)
+
+#define FAN_READ(dev, ctl, id, val) \
+	eiois200_pmc_read(dev, FAN_OP(CMD_FAN_READ, ctl, id, 0), val)
+
+/* Read a value that rarely changes through the core read cache */
+#define FAN_READ_CACHED(dev, ctl, id, val) \
+	eiois200_pmc_read(dev, FAN_OP(CMD_FAN_READ, ctl, id, CACHE_TTL), val)
+
+/* Discovery read operation for eiois200_core_pmc_batch() */
+#define FAN_READ_OP(ctl, id, data) {		\
+	.cmd       = CMD_FAN_READ,		\
+	.control   = ctl,			\
+	.device_id = ZONE_CH(id),		\
+	.size	   = EIOIS200_PMC_SIZE(data),	\
+	.payload   = (u8 *)(data),		\
+	.chip	   = ZONE_EC(id),		\
+	.timeout   = timeout,			\
+	.priority  = PMC_PRIO_BACKGROUND,	\
+	.client	   = EIOIS200_CLIENT_FAN,		\
+}
 
 static char fan_name[0x20][NAME_SIZE + 1] = {
 	"CPU0", "CPU1", "CPU2", "CPU3", "SYS0", "SYS1", "SYS2", "SYS3",
@@ -129,20 +158,6 @@ static int timeout;
 module_param(timeout, int, 0444);
 MODULE_PARM_DESC(timeout, "Set PMC command timeout value.\n");
 
-static int pmc_cmd(struct device *dev, u8 cmd, u8 ctrl, u8 id, u8 len, void *data)
-{
-	struct pmc_op op = {
-		.cmd       = cmd,
-		.control   = ctrl,
-		.device_id = id,
-		.size	   = len,
-		.payload   = (u8 *)data,
-		.timeout   = timeout,
-	};
-
-	return eiois200_core_pmc_operation(dev, &op);
-}
-
 static ssize_t set_max_state_store(struct device *dev,
 				   struct device_attribute *attr,
 				   const char *buf, size_t count)
@@ -159,7 +174,7 @@ static ssize_t set_max_state_store(struct device *dev,
 		return count;
 
 	if (trip <= TRIP_LOW)
-		ret = FAN_WRITE(dev, CTRL_PWM_HIGH + trip, id, &max);
+		ret = FAN_WRITE(dev, CTRL_PWM_HIGH + trip, id, (u8)max);
 	else
 		dev_warn(dev, "This device doesn't support write max state\n");
 
@@ -181,10 +196,10 @@ static ssize_t name_show(struct device *dev,
 	struct thermal_zone_device *zone =
 			container_of(dev, struct thermal_zone_device, device);
 	long id = (long)zone->devdata;
-	int name = 0;
+	u8 name = 0;
 	int ret;
 
-	ret = FAN_READ(dev, CTRL_TYPE, id, &name);
+	ret = FAN_READ_CACHED(dev, CTRL_TYPE, id, &name);
 	if (ret)
 		return 0;
 
@@ -200,7 +215,8 @@ static ssize_t fan_mode_store(struct device *dev,
 	struct thermal_zone_device *zone =
 			container_of(dev, struct thermal_zone_device, device);
 	long id = (long)zone->devdata;
-	int mode, val;
+	int mode;
+	u8 val;
 	char name[4][8] = { "Stop", "Full", "Manual", "Auto" };
 	int ret;
 
@@ -212,8 +228,8 @@ static ssize_t fan_mode_store(struct device *dev,
 		if (ret)
 			return -EIO;
 
-		mode |= val & 0xFC;
-		ret = FAN_WRITE(&zone->device, CTRL_CTRL, id, &mode);
+		val = (val & 0xFC) | mode;
+		ret = FAN_WRITE(&zone->device, CTRL_CTRL, id, val);
 
 		return	ret ? ret : count;
 	}
@@ -228,7 +244,7 @@ static ssize_t fan_mode_show(struct device *dev,
 	struct thermal_zone_device *zone =
 			container_of(dev, struct thermal_zone_device, device);
 	long id = (long)zone->devdata;
-	int mode = 0;
+	u8 mode = 0;
 	char name[4][8] = { "Stop", "Full", "Manual", "Auto" };
 	int ret;
 
@@ -257,7 +273,7 @@ static ssize_t PWM_store(struct device *dev,
 	if (val > 100)
 		val = 100;
 
-	ret = FAN_WRITE(&zone->device, CTRL_VALUE, id, &val);
+	ret = FAN_WRITE(&zone->device, CTRL_VALUE, id, (u8)val);
 	if (ret)
 		return ret;
 
@@ -271,7 +287,7 @@ static ssize_t PWM_show(struct device *dev,
 	struct thermal_zone_device *zone =
 			container_of(dev, struct thermal_zone_device, device);
 	long id = (long)zone->devdata;
-	int val = 0;
+	u8 val = 0;
 	int ret;
 
 	ret = FAN_READ(&zone->device, CTRL_VALUE, id, &val);
@@ -291,19 +307,22 @@ static DEVICE_ATTR_RW(PWM);
 static int get_temp(struct thermal_zone_device *zone, int *temp)
 {
 	struct device *dev = &zone->device;
-	int id = (long)zone->devdata;
-	int sensor = 0;
+	long id = (long)zone->devdata;
+	u16 sensor = 0;
 	u16 val = 0;
 	int ret;
 
 	/* Query which sensor */
-	ret = FAN_READ(dev, CTRL_CTRL, id, &sensor);
+	ret = eiois200_core_snapshot(dev, ZONE_EC(id), EIOIS200_SNAP_FAN_CTRL,
+				     ZONE_CH(id), &sensor,
+				     EIOIS200_CLIENT_FAN);
 	if (ret)
 		return ret;
 
-	/* Query temp */
-	ret = pmc_cmd(dev, CMD_THERM_READ, CTRL_VALUE,
-		      FAN_SRC(sensor), sizeof(val), &val);
+	/* Query temp, the source sensor is on the same EC */
+	ret = eiois200_core_snapshot(dev, ZONE_EC(id), EIOIS200_SNAP_TEMP,
+				     FAN_SRC(sensor), &val,
+				     EIOIS200_CLIENT_FAN);
 
 	*temp = DECI_KELVIN_TO_MILLICELSIUS(val);
 
@@ -321,7 +340,7 @@ static int get_trip_type(struct thermal_zone_device *dev, int id,
 static int get_trip_temp(struct thermal_zone_device *zone, int trip, int *temp)
 {
 	long id = (long)zone->devdata;
-	int val = 0;
+	u16 val = 0;
 	int ret;
 
 	ret = FAN_READ(&zone->device, CTRL_THERM_HIGH + trip, id, &val);
@@ -335,14 +354,15 @@ static int get_trip_temp(struct thermal_zone_device *zone, int trip, int *temp)
 static int set_trip_temp(struct thermal_zone_device *zone, const struct thermal_trip *trip, int temp)
 {
 	long id = (long)zone->devdata;
-	int val, ret;
+	u16 val;
+	int ret;
 	unsigned int trip_index = THERMAL_TRIP_PRIV_TO_INT(trip->priv);
 
 	if (temp < 1000)
 		return -EINVAL;
 
 	val = MILLICELSIUS_TO_DECI_KELVIN(temp);
-	ret = FAN_WRITE(&zone->device, CTRL_THERM_HIGH + trip_index, id, &val);
+	ret = FAN_WRITE(&zone->device, CTRL_THERM_HIGH + trip_index, id, val);
 
 	return ret;
 }
@@ -352,13 +372,14 @@ static int set_trip_temp(struct thermal_zone_device *zone, const struct thermal_
 static int set_trip_temp(struct thermal_zone_device *zone, int trip, int temp)
 {
 	long id = (long)zone->devdata;
-	int val, ret;
+	u16 val;
+	int ret;
 
 	if (temp < 1000)
 		return -EINVAL;
 
 	val = MILLICELSIUS_TO_DECI_KELVIN(temp);
-	ret = FAN_WRITE(&zone->device, CTRL_THERM_HIGH + trip, id, &val);
+	ret = FAN_WRITE(&zone->device, CTRL_THERM_HIGH + trip, id, val);
 
 	return ret;
 }
@@ -369,23 +390,28 @@ static int get_max_state(struct thermal_cooling_device *cdev,
 {
 	long id = FAN_ID(cdev->devdata);
 	long trip = FAN_TRIP(cdev->devdata);
-
-	*state = 0;
+	u8 duty = 0;
+	int ret = 0;
 
 	if (trip <= TRIP_LOW)
-		return FAN_READ(&cdev->device, CTRL_PWM_HIGH + trip, id, state);
+		ret = FAN_READ(&cdev->device, CTRL_PWM_HIGH + trip, id, &duty);
 
-	return 0;
+	*state = duty;
+
+	return ret;
 }
 
 static int get_cur_state(struct thermal_cooling_device *cdev,
 			 unsigned long *state)
 {
 	long id = FAN_ID(cdev->devdata);
+	u8 duty = 0;
+	int ret;
 
-	*state = 0;
+	ret = FAN_READ(&cdev->device, CTRL_VALUE, id, &duty);
+	*state = duty;
 
-	return FAN_READ(&cdev->device, CTRL_VALUE, id, state);
+	return ret;
 }
 
 static int set_cur_state(struct thermal_cooling_device *cdev,
@@ -492,7 +518,7 @@ static struct thermal_zone_params zone_params = {
 	.no_hwmon      = true,
 };
 
-static struct thermal_trip tz_trips[] = {
+static const struct thermal_trip trips_default[TRIP_NUM] = {
 	{ .type = THERMAL_TRIP_ACTIVE },
 	{ .type = THERMAL_TRIP_ACTIVE },
 	{ .type = THERMAL_TRIP_ACTIVE },
@@ -507,6 +533,7 @@ static int probe(struct platform_device *pdev)
 	long fan;
 	int ret = 0;
 	struct device *dev =  &pdev->dev;
+	u8 ec = eiois200_cell_chip(dev);
 
 	/* Confirm if eiois200_core exist */
 	if (!dev_get_drvdata(dev->parent)) {
@@ -516,24 +543,31 @@ static int probe(struct platform_device *pdev)
 
 	/* Init and register 4 smart fan */
 	for (fan = 0; fan < FAN_MAX; fan++) {
+		long data = ZONE_DATA(ec, fan);
 		u8 state, name;
 		int trip;
-		int trip_hi = 0, trip_lo = 0, trip_stop = 0;
-		int pwm_hi = 0, pwm_lo = 0;
+		u16 trip_hi = 0, trip_lo = 0, trip_stop = 0;
+		u8 pwm_hi = 0, pwm_lo = 0;
 		struct thermal_zone_device *zone;
+		struct thermal_trip tz_trips[TRIP_NUM];
+		struct pmc_op ops[] = {
+			FAN_READ_OP(CTRL_STATE,	     data, &state),
+			FAN_READ_OP(CTRL_TYPE,	     data, &name),
+			FAN_READ_OP(CTRL_THERM_HIGH, data, &trip_hi),
+			FAN_READ_OP(CTRL_THERM_LOW,  data, &trip_lo),
+			FAN_READ_OP(CTRL_THERM_STOP, data, &trip_stop),
+			FAN_READ_OP(CTRL_PWM_HIGH,   data, &pwm_hi),
+			FAN_READ_OP(CTRL_PWM_LOW,    data, &pwm_lo),
+		};
 
 		/* Read the fan's all params */
-		if (FAN_READ(dev, CTRL_STATE,	   fan, &state)	    ||
-		    FAN_READ(dev, CTRL_TYPE,	   fan, &name)	    ||
-		    FAN_READ(dev, CTRL_THERM_HIGH, fan, &trip_hi)   ||
-		    FAN_READ(dev, CTRL_THERM_LOW,  fan, &trip_lo)   ||
-		    FAN_READ(dev, CTRL_THERM_STOP, fan, &trip_stop) ||
-		    FAN_READ(dev, CTRL_PWM_HIGH,   fan, &pwm_hi)    ||
-		    FAN_READ(dev, CTRL_PWM_LOW,    fan, &pwm_lo)) {
+		if (eiois200_core_pmc_batch(dev, ops, ARRAY_SIZE(ops), NULL)) {
 			dev_dbg(dev, "Smart fan%ld: pmc function error\n", fan);
 			continue;
 		}
 
+		memcpy(tz_trips, trips_default, sizeof(tz_trips));
+
 #if KERNEL_VERSION(6, 14, 0) <= LINUX_VERSION_CODE
 		for (trip = 0; trip < TRIP_NUM; trip++) {
 			tz_trips[trip].flags = THERMAL_TRIP_FLAG_RW_TEMP;
@@ -561,12 +595,12 @@ static int probe(struct platform_device *pdev)
 #if KERNEL_VERSION(6, 14, 0) <= LINUX_VERSION_CODE
 		zone = devm_thermal_zone_device_register(
 				dev, "eiois200_fan", tz_trips, TRIP_NUM,
-				(1 << TRIP_NUM) - 1, (void *)fan,
+				(1 << TRIP_NUM) - 1, (void *)data,
 				&zone_ops, &zone_params, 0, 0);
 #else
 		zone = devm_thermal_zone_device_register(
 				dev, "eiois200_fan", TRIP_NUM,
-				(1 << TRIP_NUM) - 1, (void *)fan,
+				(1 << TRIP_NUM) - 1, (void *)data,
 				&zone_ops, &zone_params, 0, 0);
 #endif
 		if (!zone)
@@ -579,7 +613,7 @@ static int probe(struct platform_device *pdev)
 			int lo[] = { pwm_lo, pwm_lo, 0 };
 
 			cdev = devm_thermal_cooling_device_register(dev, "Fan",
-								    (void *)((fan << 8) | trip),
+								    (void *)((data << 8) | trip),
 						&cooling_ops);
 
 			if (IS_ERR(cdev)) {
@@ -643,12 +677,14 @@ static int probe(struct platform_device *pdev)
 }
 
 static struct platform_driver tz_driver = {
+	.probe	= probe,
 	.driver = {
-		.name = "eiois200_fan",
+		.name	    = "eiois200_fan",
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 };
 
-module_platform_driver_probe(tz_driver, probe);
+module_platform_driver(tz_driver);
 
 MODULE_AUTHOR("Adavantech");
 MODULE_DESCRIPTION("GPIO driver for Advantech EIO-IS200 embedded controller");
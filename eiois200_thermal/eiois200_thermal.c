@@ -79,6 +79,7 @@
 #define THERM_ERR_LO		 0x03
 
 #define NAME_SIZE		 5
+#define CACHE_TTL		 60000 /* millisecond */
 
 #define TRIP_NUM		 3
 #define TRIP_SHUTDOWN		 0
@@ -93,15 +94,49 @@
 #define DECI_KELVIN_TO_CELSIUS(t) (((t) - 2731) / 10)
 #define DECI_CELSIUS_TO_DECI_KELVIN(t) (t + 2731)
 
+/* Zone data: EC index and thermal channel on that EC */
+#define ZONE_DATA(ec, ch)	((((long)(ec)) << 16) | (ch))
+#define ZONE_EC(val)		(((long)(val)) >> 16)
+#define ZONE_CH(val)		(((long)(val)) & 0xFF)
+
 #define DEV_CH(val)		(((long)(val)) >> 8)
 #define DEV_TRIP(val)		(((long)(val)) & 0x0F)
 #define TO_DRVDATA(ch, trip)	((((long)(ch)) << 8) | (trip))
 
-#define THERM_WRITE(dev, ctl, id, data) \
-	pmc_cmd(dev, CMD_THERM_WRITE, ctl, id, pmc_len[ctl], data)
-
-#define THERM_READ(dev, ctl, id, data) \
-	pmc_cmd(dev, CMD_THERM_READ, ctl, id, pmc_len[ctl], data)
+/* Target of a typed accessor, the payload size comes from the value type */
+#define THERM_OP(_cmd, ctl, id, _ttl) (&(const struct pmc_op) {	\
+	.cmd       = _cmd,				\
+	.control   = ctl,				\
+	.device_id = ZONE_CH(id),			\
+	.chip	   = ZONE_EC(id),			\
+	.timeout   = timeout,				\
+	.ttl	   = _ttl,				\
+	.persist   = (_cmd) == CMD_THERM_WRITE,		\
+	.client	   = EIOIS200_CLIENT_THERMAL,		\
+})
+
+#define THERM_WRITE(dev, ctl, id, val) \
+	eiois200_pmc_write(dev, THERM_OP(CMD_THERM_WRITE, ctl, id, 0), val)
+
+#define THERM_READ(dev, ctl, id, val) \
+	eiois200_pmc_read(dev, THERM_OP(CMD_THERM_READ, ctl, id, 0), val)
+
+/* Read a value that rarely changes through the core read cache */
+#define THERM_READ_CACHED(dev, ctl, id, val) \
+	eiois200_pmc_read(dev, THERM_OP(CMD_THERM_READ, ctl, id, CACHE_TTL), val)
+
+/* Discovery read operation for eiois200_core_pmc_batch() */
+#define THERM_READ_OP(ctl, id, data) {		\
+	.cmd       = CMD_THERM_READ,		\
+	.control   = ctl,			\
+	.device_id = ZONE_CH(id),		\
+	.size	   = EIOIS200_PMC_SIZE(data),	\
+	.payload   = (u8 *)(data),		\
+	.chip	   = ZONE_EC(id),		\
+	.timeout   = timeout,			\
+	.priority  = PMC_PRIO_BACKGROUND,	\
+	.client	   = EIOIS200_CLIENT_THERMAL,	\
+}
 
 #ifndef dev_err_probe
 	#define dev_err_probe(dev, ret, fmt, args...) do { \
@@ -132,20 +167,6 @@ union thermal_status {
 	u16 value;
 };
 
-static u8 pmc_len[] = {
-/*      0, 1, 2, 3, 4, 5, 6, 7, 8, 9, a, b, c, d, e, f */
-/* 0 */	2, 1, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-/* 1 */	2, 2, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-/* 2 */	1, 2, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-/* 3 */	1, 2, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-/* 4 */	1, 2, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-/* 5 */	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-/* 6 */	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-/* 7 */	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-/* 8 */	1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-/* 9 */	2, 1, 2,
-};
-
 static char therm_name[0x20][NAME_SIZE + 1] = {
 	"CPU0", "CPU1", "CPU2", "CPU3", "SYS0", "SYS1", "SYS2", "SYS3",
 	"AUX0", "AUX1", "AUX2", "AUX3", "DIMM0", "DIMM1", "DIMM2", "DIMM3",
@@ -157,21 +178,6 @@ static int timeout;
 module_param(timeout, int, 0444);
 MODULE_PARM_DESC(timeout, "Set PMC command timeout value.\n");
 
-static int pmc_cmd(struct device *dev, u8 cmd,
-		   u8 ctrl, u8 id, u8 len, void *data)
-{
-	struct pmc_op op = {
-		.cmd       = cmd,
-		.control   = ctrl,
-		.device_id = id,
-		.size	   = len,
-		.payload   = (u8 *)data,
-		.timeout   = timeout,
-	};
-
-	return eiois200_core_pmc_operation(dev, &op);
-}
-
 static ssize_t name_show(struct device *dev,
 			 struct device_attribute *attr,
 			 char *buf)
@@ -179,10 +185,10 @@ static ssize_t name_show(struct device *dev,
 	struct thermal_zone_device *zone =
 			container_of(dev, struct thermal_zone_device, device);
 	long id = (long)zone->devdata;
-	int name = 0;
+	u8 name = 0;
 	int ret;
 
-	ret = THERM_READ(dev, CTRL_TYPE, id, &name);
+	ret = THERM_READ_CACHED(dev, CTRL_TYPE, id, &name);
 	if (ret)
 		return 0;
 
@@ -201,7 +207,7 @@ static ssize_t enable_store(struct device *dev,
 			container_of(dev, struct thermal_cooling_device, device);
 	long id = DEV_CH(cdev->devdata);
 	long trip = DEV_TRIP(cdev->devdata);
-	int enable = 0;
+	u8 enable = 0;
 	static u8 ctrl[] = {
 		CTRL_SHUTDOWN,
 		CTRL_POWEROFF,
@@ -215,7 +221,7 @@ static ssize_t enable_store(struct device *dev,
 	else
 		return -EINVAL;
 
-	ret = THERM_WRITE(dev, ctrl[trip], id, &enable);
+	ret = THERM_WRITE(dev, ctrl[trip], id, enable);
 	if (ret)
 		return ret;
 
@@ -232,7 +238,7 @@ static ssize_t enable_show(struct device *dev,
 				     struct thermal_cooling_device, device);
 	long id = DEV_CH(cdev->devdata);
 	long trip = DEV_TRIP(cdev->devdata);
-	int enable = 0;
+	u8 enable = 0;
 	static u8 ctrl[] = {
 		CTRL_SHUTDOWN,
 		CTRL_POWEROFF,
@@ -254,12 +260,14 @@ static DEVICE_ATTR_RW(enable);
 static int get_temp(struct thermal_zone_device *zone, int *temp)
 {
 	struct device *dev = &zone->device;
-	int id = (long)zone->devdata;
+	long id = (long)zone->devdata;
 	u16 val = 0;
 	int ret;
 
 	/* Query temp */
-	ret = THERM_READ(dev, CTRL_VALUE, id, &val);
+	ret = eiois200_core_snapshot(dev, ZONE_EC(id), EIOIS200_SNAP_TEMP,
+				     ZONE_CH(id), &val,
+				     EIOIS200_CLIENT_THERMAL);
 	*temp = DECI_KELVIN_TO_CELSIUS(val);
 
 	return ret;
@@ -276,7 +284,7 @@ static int get_trip_type(struct thermal_zone_device *dev, int id,
 static int get_trip_temp(struct thermal_zone_device *zone, int trip, int *temp)
 {
 	long id = (long)zone->devdata;
-	int val = 0;
+	u16 val = 0;
 	int ret;
 	static u8 ctrl[] = {
 		CTRL_SHUTDOWN_HI,
@@ -293,7 +301,8 @@ static int get_trip_temp(struct thermal_zone_device *zone, int trip, int *temp)
 #if KERNEL_VERSION(6, 14, 0) <= LINUX_VERSION_CODE
 static int set_trip_temp(struct thermal_zone_device *zone, const struct thermal_trip *trip, int temp)
 {
-	int val, ret;
+	int ret;
+	u16 val, raw;
 	long id = (long)zone->devdata;
 	static u8 ctrl[] = {
 		CTRL_SHUTDOWN_HI,
@@ -304,7 +313,7 @@ static int set_trip_temp(struct thermal_zone_device *zone, const struct thermal_
 	unsigned int trip_index = THERMAL_TRIP_PRIV_TO_INT(trip->priv);
 	int retry_cnt = 0, rdata;
 
-	if (id >= TRIP_NUM)
+	if (ZONE_CH(id) >= TRIP_NUM)
 		return -EINVAL;
 
 	if (trip_index > 3)
@@ -319,15 +328,15 @@ RETRY:
 	/* Set trigger temp */
 	val = DECI_CELSIUS_TO_DECI_KELVIN(temp);
 
-	ret = THERM_WRITE(&zone->device, ctrl[trip_index], id, &val);
+	ret = THERM_WRITE(&zone->device, ctrl[trip_index], id, val);
 
 	/* Set clear temp */
-	val -= dec[id];
+	val -= dec[ZONE_CH(id)];
 	if (!ret)
-		ret = THERM_WRITE(&zone->device, ctrl[trip_index] + 1, id, &val);
+		ret = THERM_WRITE(&zone->device, ctrl[trip_index] + 1, id, val);
 
-	if (!THERM_READ(&zone->device, ctrl[trip_index], id, &rdata)) {
-		rdata = DECI_KELVIN_TO_CELSIUS(rdata) * 10;
+	if (!THERM_READ(&zone->device, ctrl[trip_index], id, &raw)) {
+		rdata = DECI_KELVIN_TO_CELSIUS(raw) * 10;
 		if (rdata != temp && retry_cnt < 3) {
 			retry_cnt++;
 			goto RETRY;
@@ -341,7 +350,8 @@ RETRY:
 
 static int set_trip_temp(struct thermal_zone_device *zone, int trip, int temp)
 {
-	int val, ret;
+	int ret;
+	u16 val, raw;
 	long id = (long)zone->devdata;
 	static u8 ctrl[] = {
 		CTRL_SHUTDOWN_HI,
@@ -351,7 +361,7 @@ static int set_trip_temp(struct thermal_zone_device *zone, int trip, int temp)
 	static int dec[] = {10, 5, 1};
 	int retry_cnt = 0, rdata;
 
-	if (id >= TRIP_NUM)
+	if (ZONE_CH(id) >= TRIP_NUM)
 		return -EINVAL;
 
 	if (temp < 0 || temp > 125)
@@ -362,15 +372,15 @@ static int set_trip_temp(struct thermal_zone_device *zone, int trip, int temp)
 RETRY:
 	/* Set trigger temp */
 	val = DECI_CELSIUS_TO_DECI_KELVIN(temp);
-	ret = THERM_WRITE(&zone->device, ctrl[trip], id, &val);
+	ret = THERM_WRITE(&zone->device, ctrl[trip], id, val);
 
 	/* Set clear temp */
-	val -= dec[id];
+	val -= dec[ZONE_CH(id)];
 	if (!ret)
-		ret = THERM_WRITE(&zone->device, ctrl[trip] + 1, id, &val);
+		ret = THERM_WRITE(&zone->device, ctrl[trip] + 1, id, val);
 
-	if (!THERM_READ(&zone->device, ctrl[trip], id, &rdata)) {
-		rdata = DECI_KELVIN_TO_CELSIUS(rdata) * 10;
+	if (!THERM_READ(&zone->device, ctrl[trip], id, &raw)) {
+		rdata = DECI_KELVIN_TO_CELSIUS(raw) * 10;
 		if (rdata != temp && retry_cnt < 3) {
 			retry_cnt++;
 			goto RETRY;
@@ -386,7 +396,7 @@ static int get_max_state(struct thermal_cooling_device *cdev,
 {
 	int ret;
 	long id = DEV_CH(cdev->devdata);
-	int max = 0;
+	u16 max = 0;
 
 	ret = THERM_READ(&cdev->device, CTRL_MAX, id, &max);
 	*state = DECI_KELVIN_TO_CELSIUS(max);
@@ -399,9 +409,11 @@ static int get_cur_state(struct thermal_cooling_device *cdev,
 {
 	int ret;
 	long id = DEV_CH(cdev->devdata);
-	int temp = 0;
+	u16 temp = 0;
 
-	ret = THERM_READ(&cdev->device, CTRL_VALUE, id, &temp);
+	ret = eiois200_core_snapshot(&cdev->device, ZONE_EC(id),
+				     EIOIS200_SNAP_TEMP, ZONE_CH(id), &temp,
+				     EIOIS200_CLIENT_THERMAL);
 	*state = DECI_KELVIN_TO_CELSIUS(temp);
 
 	return ret;
@@ -520,7 +532,7 @@ static struct thermal_zone_params zone_params = {
 
 #if KERNEL_VERSION(6, 14, 0) <= LINUX_VERSION_CODE
 
-static struct thermal_trip tz_trips[] = {
+static const struct thermal_trip trips_default[TRIP_NUM] = {
 	{ .type = THERMAL_TRIP_CRITICAL },
 	{ .type =  THERMAL_TRIP_CRITICAL },
 	{ .type = THERMAL_TRIP_HOT },
@@ -533,6 +545,7 @@ static int probe(struct platform_device *pdev)
 	long ch;
 	int ret = 0;
 	struct device *dev = &pdev->dev;
+	u8 ec = eiois200_cell_chip(dev);
 	struct {
 		u8 enable;
 		u8 temp;
@@ -554,17 +567,31 @@ static int probe(struct platform_device *pdev)
 
 	/* Init and register 4 thermal channel */
 	for (ch = 0; ch < THERM_NUM; ch++) {
+		long data = ZONE_DATA(ec, ch);
 		union thermal_status state;
 		u8 name;
 		int trip;
-		int hi[] = { 0, 0, 0, 0 };
+		u16 hi[TRIP_NUM] = { 0 };
 		struct thermal_zone_device *zone;
 		struct thermal_cooling_device *cdev[TRIP_NUM];
 		int temps[TRIP_NUM] = { 0, 0, 0 };
+		int status[TRIP_NUM];
+#if KERNEL_VERSION(6, 14, 0) <= LINUX_VERSION_CODE
+		struct thermal_trip tz_trips[TRIP_NUM];
+#endif
+		struct pmc_op info_ops[] = {
+			THERM_READ_OP(CTRL_STATE, data, &state.value),
+			THERM_READ_OP(CTRL_TYPE,  data, &name),
+		};
+		struct pmc_op trip_ops[] = {
+			THERM_READ_OP(ctrl[0].temp, data, &hi[0]),
+			THERM_READ_OP(ctrl[1].temp, data, &hi[1]),
+			THERM_READ_OP(ctrl[2].temp, data, &hi[2]),
+		};
 
 		/* Make sure device available */
-		if (THERM_READ(dev, CTRL_STATE, ch, &state) ||
-		    THERM_READ(dev, CTRL_TYPE, ch, &name)) {
+		if (eiois200_core_pmc_batch(dev, info_ops,
+					    ARRAY_SIZE(info_ops), NULL)) {
 			dev_dbg(dev, "Thermal %ld: pmc function error\n", ch);
 			continue;
 		}
@@ -582,9 +609,19 @@ static int probe(struct platform_device *pdev)
 			continue;
 		}
 
-		/* Get all trip value */
+		/* Get all trip value, a failed trip is skipped by its status */
+		ret = eiois200_core_pmc_batch(dev, trip_ops, TRIP_NUM, status);
+		if (eiois200_batch_rejected(ret, status, TRIP_NUM)) {
+			dev_dbg(dev, "Thermal %ld: read trips error\n", ch);
+			continue;
+		}
+
+#if KERNEL_VERSION(6, 14, 0) <= LINUX_VERSION_CODE
+		memcpy(tz_trips, trips_default, sizeof(tz_trips));
+#endif
+
 		for (trip = 0 ; trip < TRIP_NUM ; trip++) {
-			if (THERM_READ(dev, ctrl[trip].temp, ch, &hi[trip])) {
+			if (status[trip]) {
 				dev_err_probe(dev, -EIO, "Read thermal_%ld error\n",
 					      ch);
 				continue;
@@ -604,14 +641,14 @@ static int probe(struct platform_device *pdev)
 #if KERNEL_VERSION(6, 14, 0) <= LINUX_VERSION_CODE
 		zone = devm_thermal_zone_device_register(
 				dev, "eiois200_thermal", tz_trips, TRIP_NUM,
-				(1 << TRIP_NUM) - 1, (void *)ch,
+				(1 << TRIP_NUM) - 1, (void *)data,
 				&zone_ops, &zone_params,
 				THERMAL_PASSIVE_DELAY,
 				THERMAL_POLLING_DELAY);
 #else
 		zone = devm_thermal_zone_device_register(
 				dev, "eiois200_thermal", TRIP_NUM,
-				(1 << TRIP_NUM) - 1, (void *)ch,
+				(1 << TRIP_NUM) - 1, (void *)data,
 				&zone_ops, &zone_params,
 				THERMAL_PASSIVE_DELAY,
 				THERMAL_POLLING_DELAY);
@@ -635,7 +672,7 @@ static int probe(struct platform_device *pdev)
 
 			cdev[trip] = devm_thermal_cooling_device_register(
 						dev, "Processor",
-						(void *)TO_DRVDATA(ch, trip),
+						(void *)TO_DRVDATA(data, trip),
 						&cooling_ops);
 			if (IS_ERR(cdev[trip])) {
 				dev_err_probe(dev, PTR_ERR(cdev[trip]),
@@ -682,12 +719,14 @@ static int probe(struct platform_device *pdev)
 }
 
 static struct platform_driver tz_driver = {
+	.probe	= probe,
 	.driver = {
-		.name = "eiois200_thermal",
+		.name	    = "eiois200_thermal",
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 };
 
-module_platform_driver_probe(tz_driver, probe);
+module_platform_driver(tz_driver);
 
 MODULE_AUTHOR("Adavantech");
 MODULE_DESCRIPTION("GPIO driver for Advantech EIO-IS200 embedded controller");
@@ -67,9 +67,6 @@
 #define CTRL_TRIGGER		0x02
 
 /* I/O register and its flags */
-#define IOREG_UNLOCK		0x87
-#define IOREG_LOCK		0xAA
-#define IOREG_LDN		0x07
 #define IOREG_LDN_PMCIO		0x0F
 #define IOREG_IRQ		0x70
 #define IOREG_WDT_STATUS	0x30
@@ -78,9 +75,33 @@
 #define FLAG_WDT_ENABLED	0x01
 #define FLAG_TRIGGER_IRQ	BIT(4)
 
+/* Target of a typed accessor, the payload size comes from the value type */
+#define WDT_OP(wdt, _cmd, ctl) (&(const struct pmc_op) {	\
+	.cmd      = _cmd,				\
+	.control  = ctl,				\
+	.chip     = (wdt)->ec,				\
+	.timeout  = timeout,				\
+	.priority = PMC_PRIO_CRITICAL,			\
+	.client   = EIOIS200_CLIENT_WDT,		\
+})
+
 /* PMC read and write a value */
-#define PMC_WRITE(cmd, data)	pmc(CMD_WDT_WRITE, cmd, data)
-#define PMC_READ(cmd, data)	pmc(CMD_WDT_READ, cmd, data)
+#define PMC_WRITE(wdt, ctl, val) \
+	eiois200_pmc_write((wdt)->dev, WDT_OP(wdt, CMD_WDT_WRITE, ctl), val)
+#define PMC_READ(wdt, ctl, val) \
+	eiois200_pmc_read((wdt)->dev, WDT_OP(wdt, CMD_WDT_READ, ctl), val)
+
+/* Read operation for eiois200_core_pmc_batch() */
+#define PMC_READ_OP(wdt, ctl, data) ((struct pmc_op) {	\
+	.cmd      = CMD_WDT_READ,			\
+	.control  = ctl,				\
+	.size     = EIOIS200_PMC_SIZE(data),		\
+	.payload  = (u8 *)(data),			\
+	.chip     = (wdt)->ec,				\
+	.timeout  = timeout,				\
+	.priority = PMC_PRIO_CRITICAL,			\
+	.client   = EIOIS200_CLIENT_WDT,		\
+})
 
 /* Mapping event type to supported bit */
 #define EVENT_BIT(type)	BIT(type + 2)
@@ -93,14 +114,15 @@ enum event_type {
 	EVENT_PIN
 };
 
-static struct _wdt {
+struct _wdt {
 	u32	event_type;
 	u32	support;
 	u32	irq;
 	long	last_time;
-	struct	regmap  *iomap;
+	u8	ec;
 	struct	device *dev;
-} wdt;
+	struct	watchdog_device wddev;
+};
 
 static char * const type_strs[] = {
 	"NONE",
@@ -118,18 +140,12 @@ static u32 type_regs[] = {
 	REG_PIN_EVENT_TIME,
 };
 
-static struct watchdog_info wdinfo = {
+static const struct watchdog_info wdinfo = {
 	.identity = KBUILD_MODNAME,
 	.options  = WDIOF_SETTIMEOUT | WDIOF_KEEPALIVEPING |
 		    WDIOF_PRETIMEOUT | WDIOF_MAGICCLOSE,
 };
 
-static struct watchdog_device wddev = {
-	.info	     = &wdinfo,
-	.max_timeout = 0x7FFF,
-	.min_timeout = 1,
-};
-
 /* Pointer to the eiois200_core device structure */
 static struct eiois200_dev *eiois200_dev;
 
@@ -151,8 +167,10 @@ MODULE_PARM_DESC(timeout, "Set PMC command timeout value.\n");
 static int wdt_set_timeout(struct watchdog_device *dev,
 			   unsigned int timeout)
 {
+	struct _wdt *wdt = watchdog_get_drvdata(dev);
+
 	dev->timeout = timeout;
-	dev_info(wdt.dev, "Set timeout: %d\n", timeout);
+	dev_info(wdt->dev, "Set timeout: %d\n", timeout);
 
 	return 0;
 }
@@ -160,136 +178,131 @@ static int wdt_set_timeout(struct watchdog_device *dev,
 static int wdt_set_pretimeout(struct watchdog_device *dev,
 			      unsigned int pretimeout)
 {
+	struct _wdt *wdt = watchdog_get_drvdata(dev);
+
 	dev->pretimeout = pretimeout;
 
-	dev_info(wdt.dev, "Set pretimeout: %d\n", pretimeout);
+	dev_info(wdt->dev, "Set pretimeout: %d\n", pretimeout);
 
 	return 0;
 }
 
-static int wdt_get_type(void)
+static int wdt_get_type(struct _wdt *wdt)
 {
 	int i;
 
 	for (i = 1; i < ARRAY_SIZE(type_strs); i++)
 		if (strcasecmp(event_type, type_strs[i]) == 0) {
-			if ((wdt.support & EVENT_BIT(i)) == 0) {
-				dev_err(wdt.dev,
+			if ((wdt->support & EVENT_BIT(i)) == 0) {
+				dev_err(wdt->dev,
 					"This board doesn't support %s trigger type\n",
 					event_type);
 				return -EINVAL;
 			}
 
-			dev_info(wdt.dev, "Trigger type is %d:%s\n",
+			dev_info(wdt->dev, "Trigger type is %d:%s\n",
 				 i, type_strs[i]);
-			wdt.event_type = i;
+			wdt->event_type = i;
 
 			return 0;
 		}
 
-	dev_info(wdt.dev, "Event type: %s\n", type_strs[wdt.event_type]);
+	dev_info(wdt->dev, "Event type: %s\n", type_strs[wdt->event_type]);
 	return 0;
 }
 
-static int pmc(u8 cmd, u8 ctrl, void *payload)
-{
-	struct pmc_op op = {
-		.cmd      = cmd,
-		.control  = ctrl,
-		.size     = ctrl <= REG_EVENT	   ? 1 :
-			    ctrl >= REG_IRQ_NUMBER ? 1 : 4,
-		.payload  = payload,
-		.timeout  = timeout,
-	};
-
-	return eiois200_core_pmc_operation(wdt.dev, &op);
-}
-
-static int get_time(u8 ctrl, u32 *val)
-{
-	int ret;
-
-	ret = PMC_READ(ctrl, val);
-
-	/* ms to sec */
-	*val /= 1000;
-
-	return ret;
-}
-
-static int set_time(u8 ctl, u32 time)
+static int set_time(struct _wdt *wdt, u8 ctl, u32 time)
 {
 	/* sec to msec */
 	time *= 1000;
 
-	return PMC_WRITE(ctl, &time);
+	return PMC_WRITE(wdt, ctl, time);
 }
 
-static int wdt_set_config(void)
+static int wdt_set_config(struct _wdt *wdt)
 {
 	int ret, type;
 	u32 event_time = 0;
 	u32 reset_time = 0;
 
 	/* event_type should never out of range */
-	if (wdt.event_type > EVENT_PIN)
+	if (wdt->event_type > EVENT_PIN)
 		return -EFAULT;
 
 	/* Calculate event time and reset time */
-	if (wddev.pretimeout && wddev.timeout) {
-		if (wddev.timeout < wddev.pretimeout)
+	if (wdt->wddev.pretimeout && wdt->wddev.timeout) {
+		if (wdt->wddev.timeout < wdt->wddev.pretimeout)
 			return -EINVAL;
 
-		reset_time = wddev.timeout;
-		event_time = wddev.timeout - wddev.pretimeout;
+		reset_time = wdt->wddev.timeout;
+		event_time = wdt->wddev.timeout - wdt->wddev.pretimeout;
 
-	} else if (wddev.timeout) {
-		reset_time = wdt.event_type ? 0	: wddev.timeout;
-		event_time = wdt.event_type ? wddev.timeout : 0;
+	} else if (wdt->wddev.timeout) {
+		reset_time = wdt->event_type ? 0	: wdt->wddev.timeout;
+		event_time = wdt->event_type ? wdt->wddev.timeout : 0;
 	}
 
 	/* Set reset time */
-	ret = set_time(REG_RESET_EVENT_TIME, reset_time);
+	ret = set_time(wdt, REG_RESET_EVENT_TIME, reset_time);
 	if (ret)
 		return ret;
 
 	/* Set every other times */
 	for (type = 1; type < ARRAY_SIZE(type_regs); type++) {
-		ret = set_time(type_regs[type],
-			       wdt.event_type == type ? event_time : 0);
+		ret = set_time(wdt, type_regs[type],
+			       wdt->event_type == type ? event_time : 0);
 		if (ret)
 			return ret;
 	}
 
-	dev_dbg(wdt.dev, "Config wdt reset time %d\n", reset_time);
-	dev_dbg(wdt.dev, "Config wdt event time %d\n", event_time);
-	dev_dbg(wdt.dev, "Config wdt event type %s\n",
-		type_strs[wdt.event_type]);
+	dev_dbg(wdt->dev, "Config wdt reset time %d\n", reset_time);
+	dev_dbg(wdt->dev, "Config wdt event time %d\n", event_time);
+	dev_dbg(wdt->dev, "Config wdt event type %s\n",
+		type_strs[wdt->event_type]);
 
 	return ret;
 }
 
-static int wdt_get_config(void)
+static int wdt_get_config(struct _wdt *wdt)
 {
-	int ret, type;
+	int ret, type, num = 0;
 	u32 event_time, reset_time;
+	u32 times[ARRAY_SIZE(type_regs)] = { 0 };
+	int status[ARRAY_SIZE(type_regs)] = { 0 };
+	struct pmc_op ops[ARRAY_SIZE(type_regs)];
 
-	/* Get Reset Time */
-	ret = get_time(REG_RESET_EVENT_TIME, &reset_time);
+	/* Read reset time and every supported event time in one batch */
+	for (type = 0; type < ARRAY_SIZE(type_regs); type++) {
+		if (type && (wdt->support & EVENT_BIT(type)) == 0)
+			continue;
+
+		ops[num++] = PMC_READ_OP(wdt, type_regs[type], &times[type]);
+	}
+
+	ret = eiois200_core_pmc_batch(wdt->dev, ops, num, status);
 	if (ret)
 		return ret;
 
-	dev_dbg(wdt.dev, "Timeout H/W default timeout: %d secs\n", reset_time);
+	/* Get Reset Time */
+	if (status[0])
+		return status[0];
+
+	/* ms to sec */
+	reset_time = times[0] / 1000;
+
+	dev_dbg(wdt->dev, "Timeout H/W default timeout: %d secs\n", reset_time);
 
 	/* Get every other times **/
-	for (type = 1; type < ARRAY_SIZE(type_regs); type++) {
-		if ((wdt.support & EVENT_BIT(type)) == 0)
+	for (type = 1, num = 1; type < ARRAY_SIZE(type_regs); type++) {
+		if ((wdt->support & EVENT_BIT(type)) == 0)
 			continue;
 
-		ret = get_time(type_regs[type], &event_time);
+		ret = status[num++];
 		if (ret)
 			return ret;
 
+		event_time = times[type] / 1000;
+
 		if (event_time == 0)
 			continue;
 
@@ -297,48 +310,49 @@ static int wdt_get_config(void)
 			if (reset_time < event_time)
 				continue;
 
-			wddev.timeout = reset_time;
-			wddev.pretimeout = reset_time - event_time;
+			wdt->wddev.timeout = reset_time;
+			wdt->wddev.pretimeout = reset_time - event_time;
 
-			dev_dbg(wdt.dev, "Pretimeout H/W enabled with event %s of %d secs\n",
-				type_strs[type], wddev.pretimeout);
+			dev_dbg(wdt->dev, "Pretimeout H/W enabled with event %s of %d secs\n",
+				type_strs[type], wdt->wddev.pretimeout);
 		} else {
-			wddev.timeout = event_time;
-			wddev.pretimeout = 0;
+			wdt->wddev.timeout = event_time;
+			wdt->wddev.pretimeout = 0;
 		}
 
-		wdt.event_type = type;
+		wdt->event_type = type;
 
-		dev_dbg(wdt.dev, "Timeout H/W enabled of %d secs\n",
-			wddev.timeout);
+		dev_dbg(wdt->dev, "Timeout H/W enabled of %d secs\n",
+			wdt->wddev.timeout);
 		return 0;
 	}
 
-	wdt.event_type	 = EVENT_NONE;
-	wddev.pretimeout = reset_time ? 0	   : WATCHDOG_PRETIMEOUT;
-	wddev.timeout	 = reset_time ? reset_time : WATCHDOG_TIMEOUT;
+	wdt->event_type	      = EVENT_NONE;
+	wdt->wddev.pretimeout = reset_time ? 0	        : WATCHDOG_PRETIMEOUT;
+	wdt->wddev.timeout    = reset_time ? reset_time : WATCHDOG_TIMEOUT;
 
-	dev_dbg(wdt.dev, "Pretimeout H/W disabled");
+	dev_dbg(wdt->dev, "Pretimeout H/W disabled");
 	return 0;
 }
 
-static int set_ctrl(u8 data)
+static int set_ctrl(struct _wdt *wdt, u8 data)
 {
-	return PMC_WRITE(REG_CONTROL, &data);
+	return PMC_WRITE(wdt, REG_CONTROL, data);
 }
 
 static int wdt_start(struct watchdog_device *dev)
 {
+	struct _wdt *wdt = watchdog_get_drvdata(dev);
 	int ret;
 
-	ret = wdt_set_config();
+	ret = wdt_set_config(wdt);
 	if (ret)
 		return ret;
 
-	ret = set_ctrl(CTRL_START);
+	ret = set_ctrl(wdt, CTRL_START);
 	if (ret == 0) {
-		wdt.last_time = jiffies;
-		dev_dbg(wdt.dev, "Watchdog started\n");
+		wdt->last_time = jiffies;
+		dev_dbg(wdt->dev, "Watchdog started\n");
 	}
 
 	return ret;
@@ -346,40 +360,44 @@ static int wdt_start(struct watchdog_device *dev)
 
 static int wdt_stop(struct watchdog_device *dev)
 {
-	dev_dbg(wdt.dev, "Watchdog stopped\n");
-	wdt.last_time = 0;
+	struct _wdt *wdt = watchdog_get_drvdata(dev);
 
-	return set_ctrl(CTRL_STOP);
+	dev_dbg(wdt->dev, "Watchdog stopped\n");
+	wdt->last_time = 0;
+
+	return set_ctrl(wdt, CTRL_STOP);
 }
 
 static int wdt_ping(struct watchdog_device *dev)
 {
+	struct _wdt *wdt = watchdog_get_drvdata(dev);
 	int ret;
 
-	dev_dbg(wdt.dev, "Watchdog pings\n");
+	dev_dbg(wdt->dev, "Watchdog pings\n");
 
-	ret = set_ctrl(CTRL_TRIGGER);
+	ret = set_ctrl(wdt, CTRL_TRIGGER);
 	if (ret == 0)
-		wdt.last_time = jiffies;
+		wdt->last_time = jiffies;
 
 	return ret;
 }
 
 static unsigned int wdt_get_timeleft(struct watchdog_device *dev)
 {
+	struct _wdt *wdt = watchdog_get_drvdata(dev);
 	unsigned int timeleft = 0;
 
-	if (wdt.last_time != 0)
-		timeleft = wddev.timeout - ((jiffies - wdt.last_time) / HZ);
+	if (wdt->last_time != 0)
+		timeleft = wdt->wddev.timeout - ((jiffies - wdt->last_time) / HZ);
 
 	return timeleft;
 }
 
-static int wdt_support(void)
+static int wdt_support(struct _wdt *wdt)
 {
 	u8 support;
 
-	if (PMC_READ(REG_STATUS, &support))
+	if (PMC_READ(wdt, REG_STATUS, &support))
 		return -EIO;
 
 	if ((support & SUPPORT_AVAILABLE) == 0)
@@ -390,70 +408,62 @@ static int wdt_support(void)
 		return -EIO;
 
 	/* Must has support event **/
-	wdt.support = support;
+	wdt->support = support;
 
 	return 0;
 }
 
-static int wdt_get_irq_io(void)
+static int wdt_get_irq_io(struct _wdt *wdt)
 {
-	int ret  = 0;
-	int idx  = EIOIS200_PNP_INDEX;
-	int data = EIOIS200_PNP_DATA;
-	struct regmap *map = wdt.iomap;
-
-	mutex_lock(&eiois200_dev->mutex);
-
-	/* Unlock EC IO port */
-	ret |= regmap_write(map, idx,  IOREG_UNLOCK);
-	ret |= regmap_write(map, idx,  IOREG_UNLOCK);
+	u8 irq;
 
-	/* Select logical device to PMC */
-	ret |= regmap_write(map, idx,  IOREG_LDN);
-	ret |= regmap_write(map, data, IOREG_LDN_PMCIO);
-
-	/* Get IRQ number */
-	ret |= regmap_write(map, idx,  IOREG_IRQ);
-	ret |= regmap_read(map, data, &wdt.irq);
-
-	/* Lock up */
-	ret |= regmap_write(map, idx,  IOREG_LOCK);
+	/* Get IRQ number of the watchdog logical device */
+	if (eiois200_core_pnp_read(wdt->dev, wdt->ec, IOREG_LDN_PMCIO,
+				   IOREG_IRQ, &irq))
+		return -EIO;
 
-	mutex_unlock(&eiois200_dev->mutex);
+	wdt->irq = irq;
 
-	return ret ? -EIO : 0;
+	return 0;
 }
 
-static int wdt_get_irq_pmc(void)
+static int wdt_get_irq_pmc(struct _wdt *wdt)
 {
-	return PMC_READ(REG_IRQ_NUMBER, &wdt.irq);
+	u8 irq;
+	int ret;
+
+	ret = PMC_READ(wdt, REG_IRQ_NUMBER, &irq);
+	if (!ret)
+		wdt->irq = irq;
+
+	return ret;
 }
 
-static int wdt_get_irq(struct device *dev)
+static int wdt_get_irq(struct _wdt *wdt, struct device *dev)
 {
 	int ret;
 
-	if ((wdt.support & BIT(EVENT_IRQ)) == 0)
+	if ((wdt->support & BIT(EVENT_IRQ)) == 0)
 		return -ENODEV;
 
 	/* Get IRQ number through PMC */
-	ret = wdt_get_irq_pmc();
+	ret = wdt_get_irq_pmc(wdt);
 	if (ret) {
 		dev_err(dev, "Error get irq by pmc\n");
 		return ret;
 	}
 
-	if (wdt.irq)
+	if (wdt->irq)
 		return 0;
 
 	/* Get IRQ number from the watchdog device in EC */
-	ret = wdt_get_irq_io();
+	ret = wdt_get_irq_io(wdt);
 	if (ret) {
 		dev_err(dev, "Error get irq by io\n");
 		return ret;
 	}
 
-	if (wdt.irq == 0) {
+	if (wdt->irq == 0) {
 		dev_err(dev, "Error IRQ number = 0\n");
 		return ret;
 	}
@@ -461,60 +471,45 @@ static int wdt_get_irq(struct device *dev)
 	return ret;
 }
 
-static int wdt_set_irq_io(void)
+static int wdt_set_irq_io(struct _wdt *wdt)
 {
-	int ret  = 0;
-	int idx  = EIOIS200_PNP_INDEX;
-	int data = EIOIS200_PNP_DATA;
-	struct regmap *map = wdt.iomap;
-
-	mutex_lock(&eiois200_dev->mutex);
-
-	/* Unlock EC IO port */
-	ret |= regmap_write(map, idx,  IOREG_UNLOCK);
-	ret |= regmap_write(map, idx,  IOREG_UNLOCK);
-
-	/* Select logical device to PMC */
-	ret |= regmap_write(map, idx,  IOREG_LDN);
-	ret |= regmap_write(map, data, IOREG_LDN_PMCIO);
-
-	/* Enable WDT */
-	ret |= regmap_write(map, idx,  IOREG_WDT_STATUS);
-	ret |= regmap_write(map, data, FLAG_WDT_ENABLED);
-
-	/* Set IRQ number */
-	ret |= regmap_write(map, idx,  IOREG_IRQ);
-	ret |= regmap_write(map, data, wdt.irq);
-
-	/* Lock up */
-	ret |= regmap_write(map, idx,  IOREG_LOCK);
+	struct pnp_op ops[] = {
+		/* Enable WDT */
+		{ .ldn = IOREG_LDN_PMCIO, .reg = IOREG_WDT_STATUS,
+		  .val = FLAG_WDT_ENABLED, .write = true },
+
+		/* Set IRQ number */
+		{ .ldn = IOREG_LDN_PMCIO, .reg = IOREG_IRQ,
+		  .val = wdt->irq, .write = true },
+	};
 
-	mutex_unlock(&eiois200_dev->mutex);
+	if (eiois200_core_pnp_batch(wdt->dev, wdt->ec, ops, ARRAY_SIZE(ops)))
+		return -EIO;
 
-	return ret ? -EIO : 0;
+	return 0;
 }
 
-static int wdt_set_irq_pmc(void)
+static int wdt_set_irq_pmc(struct _wdt *wdt)
 {
-	return PMC_WRITE(REG_IRQ_NUMBER, &wdt.irq);
+	return PMC_WRITE(wdt, REG_IRQ_NUMBER, (u8)wdt->irq);
 }
 
-static int wdt_set_irq(struct device *dev)
+static int wdt_set_irq(struct _wdt *wdt, struct device *dev)
 {
 	int ret;
 
-	if ((wdt.support & BIT(EVENT_IRQ)) == 0)
+	if ((wdt->support & BIT(EVENT_IRQ)) == 0)
 		return -ENODEV;
 
 	/* Set IRQ number to the watchdog device in EC */
-	ret = wdt_set_irq_io();
+	ret = wdt_set_irq_io(wdt);
 	if (ret) {
 		dev_err(dev, "Error set irq by io\n");
 		return ret;
 	}
 
 	/* Notice EC that watchdog IRQ changed */
-	ret = wdt_set_irq_pmc();
+	ret = wdt_set_irq_pmc(wdt);
 	if (ret) {
 		dev_err(dev, "Error set irq by pmc\n");
 		return ret;
@@ -528,11 +523,11 @@ static int wdt_set_irq(struct device *dev)
  * Returns:	The current status read from the PMC,
  *		or 0 if there was an error.
  */
-static int wdt_get_irq_event(void)
+static int wdt_get_irq_event(struct _wdt *wdt)
 {
 	u8 status;
 
-	if (PMC_READ(REG_EVENT, &status))
+	if (PMC_READ(wdt, REG_EVENT, &status))
 		return 0;
 
 	return status;
@@ -545,13 +540,14 @@ static irqreturn_t wdt_isr(int irq, void *arg)
 
 static irqreturn_t wdt_threaded_isr(int irq, void *arg)
 {
-	u8 status = wdt_get_irq_event() & FLAG_TRIGGER_IRQ;
+	struct _wdt *wdt = arg;
+	u8 status = wdt_get_irq_event(wdt) & FLAG_TRIGGER_IRQ;
 
 	if (!status)
 		return IRQ_NONE;
 
-	if (wddev.pretimeout) {
-		watchdog_notify_pretimeout(&wddev);
+	if (wdt->wddev.pretimeout) {
+		watchdog_notify_pretimeout(&wdt->wddev);
 	} else {
 		pr_crit("Watchdog Timer expired. Initiating system reboot\n");
 		emergency_restart();
@@ -560,41 +556,41 @@ static irqreturn_t wdt_threaded_isr(int irq, void *arg)
 	return IRQ_HANDLED;
 }
 
-static int query_irq(struct device *dev)
+static int query_irq(struct _wdt *wdt, struct device *dev)
 {
 	int ret;
 
 	if (irq) {
-		wdt.irq = irq;
+		wdt->irq = irq;
 	} else {
-		ret = wdt_get_irq(dev);
+		ret = wdt_get_irq(wdt, dev);
 		if (ret)
 			return ret;
 	}
 
-	dev_dbg(wdt.dev, "IRQ = %d\n", wdt.irq);
+	dev_dbg(wdt->dev, "IRQ = %d\n", wdt->irq);
 
-	return wdt_set_irq(dev);
+	return wdt_set_irq(wdt, dev);
 }
 
-static int wdt_init(struct device *dev)
+static int wdt_init(struct _wdt *wdt, struct device *dev)
 {
 	int ret = 0;
 
-	ret = wdt_support();
+	ret = wdt_support(wdt);
 	if (ret)
 		return ret;
 
-	ret = wdt_get_config();
+	ret = wdt_get_config(wdt);
 	if (ret)
 		return ret;
 
-	ret = wdt_get_type();
+	ret = wdt_get_type(wdt);
 	if (ret)
 		return ret;
 
-	if (wdt.event_type == EVENT_IRQ)
-		ret = query_irq(dev);
+	if (wdt->event_type == EVENT_IRQ)
+		ret = query_irq(wdt, dev);
 
 	return ret;
 }
@@ -613,6 +609,7 @@ static int wdt_probe(struct platform_device *pdev)
 {
 	int ret = 0;
 	struct device *dev = &pdev->dev;
+	struct _wdt *wdt;
 
 	/* Contact eiois200_core */
 	eiois200_dev = dev_get_drvdata(dev->parent);
@@ -621,44 +618,49 @@ static int wdt_probe(struct platform_device *pdev)
 		return -ENXIO;
 	}
 
-	wdt.dev = dev;
-	wdt.iomap = dev_get_regmap(dev->parent, NULL);
-	if (!wdt.iomap) {
-		dev_err(dev, "Query parent regmap fail\n");
+	wdt = devm_kzalloc(dev, sizeof(*wdt), GFP_KERNEL);
+	if (!wdt)
 		return -ENOMEM;
-	}
+
+	wdt->wddev.info	       = &wdinfo;
+	wdt->wddev.max_timeout = 0x7FFF;
+	wdt->wddev.min_timeout = 1;
+	watchdog_set_drvdata(&wdt->wddev, wdt);
+
+	wdt->ec = eiois200_cell_chip(dev);
+	wdt->dev = dev;
 
 	/* Initialize EC watchdog */
-	if (wdt_init(dev)) {
+	if (wdt_init(wdt, dev)) {
 		dev_err(dev, "wdt_init fail\n");
 		return -EIO;
 	}
 
 	/* Request IRQ */
-	if (wdt.event_type == EVENT_IRQ)
-		ret = devm_request_threaded_irq(dev, wdt.irq, wdt_isr,
+	if (wdt->event_type == EVENT_IRQ)
+		ret = devm_request_threaded_irq(dev, wdt->irq, wdt_isr,
 						wdt_threaded_isr,
-						IRQF_SHARED, pdev->name, dev);
+						IRQF_SHARED, pdev->name, wdt);
 	if (ret) {
 		dev_err(dev, "IRQ %d request fail:%d. Disabled.\n",
-			wdt.irq, ret);
+			wdt->irq, ret);
 		return ret;
 	}
 
 	/* Inform watchdog info */
-	wddev.ops = &wdt_ops;
-	ret = watchdog_init_timeout(&wddev, wddev.timeout, dev);
+	wdt->wddev.ops = &wdt_ops;
+	ret = watchdog_init_timeout(&wdt->wddev, wdt->wddev.timeout, dev);
 	if (ret) {
 		dev_err(dev, "Init timeout fail\n");
 		return ret;
 	}
 
-	watchdog_stop_on_reboot(&wddev);
+	watchdog_stop_on_reboot(&wdt->wddev);
 
-	watchdog_stop_on_unregister(&wddev);
+	watchdog_stop_on_unregister(&wdt->wddev);
 
 	/* Register watchdog */
-	ret = devm_watchdog_register_device(dev, &wddev);
+	ret = devm_watchdog_register_device(dev, &wdt->wddev);
 	if (ret) {
 		dev_err(dev, "Cannot register watchdog device (err: %d)\n",
 			ret);
@@ -669,11 +671,13 @@ static int wdt_probe(struct platform_device *pdev)
 }
 
 static struct platform_driver eiois200_wdt_driver = {
+	.probe	= wdt_probe,
 	.driver = {
-		.name  = "eiois200_wdt",
+		.name	    = "eiois200_wdt",
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 };
-module_platform_driver_probe(eiois200_wdt_driver, wdt_probe);
+module_platform_driver(eiois200_wdt_driver);
 
 MODULE_AUTHOR("wenkai <advantech.susiteam@gmail.com>");
 MODULE_DESCRIPTION("Watchdog interface for Advantech EIO-IS200 embedded controller");
@@ -14,6 +14,8 @@
 #include <linux/mfd/eiois200.h>
 
 #define GPIO_MAX_PINS	48
+#define GPIO_GROUP_NUM	4
+#define GPIO_DIR_TTL	10000 /* Cache lifetime of pin direction in msec */
 #define GPIO_WRITE	0x18
 #define GPIO_READ	0x19
 
@@ -22,20 +24,9 @@ struct eiois200_dev *eiois200_dev;
 struct _gpio_dev {
 	u64 avail;
 	int max;
+	u8  ec;
 	struct regmap *regmap;
 	struct gpio_chip chip;
-} *gpio_dev = NULL;
-
-struct {
-	int size;
-	bool write;
-} ctrl_para[] = {
-	{ 0x01, false }, { 0x00, false }, { 0x00, false }, { 0x02, false },
-	{ 0x01, false }, { 0x00, false }, { 0x00, false }, { 0x00, false },
-	{ 0x00, false }, { 0x00, false }, { 0x00, false }, { 0x00, false },
-	{ 0x00, false }, { 0x00, false }, { 0x00, false }, { 0x00, false },
-	{ 0x01, true  }, { 0x01, true  }, { 0x02, true  }, { 0x02, true  },
-	{ 0x02, false }, { 0x10, false }
 };
 
 enum {
@@ -67,51 +58,45 @@ static int timeout;
 module_param(timeout, int, 0444);
 MODULE_PARM_DESC(timeout, "Set PMC command timeout value.\n");
 
-static int pmc_write(u8 ctrl, u8 dev_id, void *data)
-{
-	struct   pmc_op op = {
-		 .cmd       = GPIO_WRITE,
-		 .control   = ctrl,
-		 .device_id = dev_id,
-		 .payload   = (u8 *)data,
-		 .timeout   = timeout,
-	};
-
-	if (ctrl > ARRAY_SIZE(ctrl_para))
-		return -ENOMEM;
-
-	if (!ctrl_para[ctrl].write)
-		return -EINVAL;
-
-	op.size = ctrl_para[ctrl].size;
-
-	return eiois200_core_pmc_operation(NULL, &op);
-}
-
-static int pmc_read(u8 ctrl, u8 dev_id, void *data)
-{
-	struct   pmc_op op = {
-		 .cmd       = GPIO_READ,
-		 .control   = ctrl,
-		 .device_id = dev_id,
-		 .payload   = (u8 *)data,
-		 .timeout   = timeout,
-	};
-
-	if (ctrl > ARRAY_SIZE(ctrl_para))
-		return -ENOMEM;
-
-	op.size = ctrl_para[ctrl].size;
-
-	return eiois200_core_pmc_operation(NULL, &op);
-}
+/* Target of a typed accessor, the payload size comes from the value type */
+#define GPIO_OP(gpio, _cmd, ctl, id, _ttl) (&(const struct pmc_op) {	\
+	.cmd       = _cmd,				\
+	.control   = ctl,				\
+	.device_id = id,				\
+	.chip      = (gpio)->ec,			\
+	.timeout   = timeout,				\
+	.ttl	   = _ttl,				\
+	.client	   = EIOIS200_CLIENT_GPIO,		\
+})
+
+#define PMC_WRITE(gpio, ctl, id, val) \
+	eiois200_pmc_write(NULL, GPIO_OP(gpio, GPIO_WRITE, ctl, id, 0), val)
+
+#define PMC_READ(gpio, ctl, id, val) \
+	eiois200_pmc_read(NULL, GPIO_OP(gpio, GPIO_READ, ctl, id, 0), val)
+
+/* Discovery read operation for eiois200_core_pmc_batch() */
+#define PMC_READ_OP(gpio, ctl, id, data) ((struct pmc_op) {	\
+	.cmd       = GPIO_READ,				\
+	.control   = ctl,				\
+	.device_id = id,				\
+	.size      = EIOIS200_PMC_SIZE(data),		\
+	.payload   = (u8 *)(data),			\
+	.chip      = (gpio)->ec,			\
+	.timeout   = timeout,				\
+	.priority  = PMC_PRIO_BACKGROUND,		\
+	.client	   = EIOIS200_CLIENT_GPIO,		\
+})
 
 static int get_dir(struct gpio_chip *chip, unsigned int offset)
 {
+	struct _gpio_dev *gpio = gpiochip_get_data(chip);
 	u8 dir;
 	int ret;
 
-	ret = pmc_read(GPIO_PIN_DIR, offset, &dir);
+	/* Direction changes go through the core, which drops the cache */
+	ret = eiois200_pmc_read(NULL, GPIO_OP(gpio, GPIO_READ, GPIO_PIN_DIR,
+					      offset, GPIO_DIR_TTL), &dir);
 	if (ret)
 		return ret;
 
@@ -122,17 +107,18 @@ static int dir_input(struct gpio_chip *chip, unsigned int offset)
 {
 	u8 dir = 0;
 
-	return pmc_write(GPIO_PIN_DIR, offset, &dir);
+	return PMC_WRITE(gpiochip_get_data(chip), GPIO_PIN_DIR, offset, dir);
 }
 
 static int dir_output(struct gpio_chip *chip, unsigned int offset, int value)
 {
+	struct _gpio_dev *gpio = gpiochip_get_data(chip);
 	u8 dir = 1;
 	u8 val = value;
 
-	pmc_write(GPIO_PIN_DIR, offset, &dir);
+	PMC_WRITE(gpio, GPIO_PIN_DIR, offset, dir);
 
-	return pmc_write(GPIO_PIN_LEVEL, offset, &val);
+	return PMC_WRITE(gpio, GPIO_PIN_LEVEL, offset, val);
 }
 
 static int gpio_get(struct gpio_chip *chip, unsigned int offset)
@@ -140,7 +126,7 @@ static int gpio_get(struct gpio_chip *chip, unsigned int offset)
 	u8 level;
 	int ret;
 
-	ret = pmc_read(GPIO_PIN_LEVEL, offset, &level);
+	ret = PMC_READ(gpiochip_get_data(chip), GPIO_PIN_LEVEL, offset, &level);
 	if (ret)
 		return ret;
 
@@ -151,15 +137,15 @@ static void gpio_set(struct gpio_chip *chip, unsigned int offset, int value)
 {
 	u8 val = value;
 
-	pmc_write(GPIO_PIN_LEVEL, offset, &val);
+	PMC_WRITE(gpiochip_get_data(chip), GPIO_PIN_LEVEL, offset, val);
 }
 
-static int check_support(void)
+static int check_support(struct _gpio_dev *gpio)
 {
 	u8  data;
 	int ret;
 
-	ret = pmc_read(GPIO_STATUS, 0, &data);
+	ret = PMC_READ(gpio, GPIO_STATUS, 0, &data);
 	if (!ret)
 		return ret;
 
@@ -169,50 +155,71 @@ static int check_support(void)
 	return 0;
 }
 
-static int check_pin(int pin)
-{
-	int ret;
-	int group, bit;
-	u16 data;
-
-	/* Get pin mapping */
-	ret = pmc_read(GPIO_MAPPING, pin, &data);
-	if (ret)
-		return ret;
-
-	if ((data & 0xFF) > ARRAY_SIZE(group_map))
-		return -EINVAL;
-
-	group = group_map[data & 0xFF].group;
-	bit   = data >> 8;
-
-	/* Check mapped pin */
-	ret = pmc_read(GPIO_GROUP_AVAIL, group, &data);
-	if (ret)
-		return ret;
-
-	return data & BIT(bit) ? 0 : -ENOTSUPP;
-}
-
-static int gpio_init(void)
+static int gpio_init(struct _gpio_dev *gpio_dev)
 {
 	int ret;
 	int i;
 	char str[GPIO_MAX_PINS + 1];
+	u16 group_avail[GPIO_GROUP_NUM];
+	int group_status[GPIO_GROUP_NUM];
+	struct pmc_op group_ops[GPIO_GROUP_NUM];
+	struct {
+		struct pmc_op op[GPIO_MAX_PINS];
+		int status[GPIO_MAX_PINS];
+		u16 map[GPIO_MAX_PINS];
+	} *pins;
 
 	memset(str, 0x30, sizeof(str));
 
-	ret = check_support();
+	ret = check_support(gpio_dev);
 	if (ret) {
 		pr_err("Error get GPIO support state\n");
 		return ret;
 	}
 
+	pins = kzalloc(sizeof(*pins), GFP_KERNEL);
+	if (!pins)
+		return -ENOMEM;
+
+	/* Read all groups available bits and all pins mapping in 2 batches */
+	for (i = 0 ; i < GPIO_GROUP_NUM ; i++)
+		group_ops[i] = PMC_READ_OP(gpio_dev, GPIO_GROUP_AVAIL, i,
+					   &group_avail[i]);
+
+	for (i = 0 ; i < GPIO_MAX_PINS ; i++)
+		pins->op[i] = PMC_READ_OP(gpio_dev, GPIO_MAPPING, i,
+					  &pins->map[i]);
+
+	/* A failed read only drops its group or pin, like check_pin() did */
+	ret = eiois200_core_pmc_batch(NULL, group_ops, GPIO_GROUP_NUM,
+				      group_status);
+	if (!eiois200_batch_rejected(ret, group_status, GPIO_GROUP_NUM)) {
+		ret = eiois200_core_pmc_batch(NULL, pins->op, GPIO_MAX_PINS,
+					      pins->status);
+		if (!eiois200_batch_rejected(ret, pins->status, GPIO_MAX_PINS))
+			ret = 0;
+	}
+
+	if (ret) {
+		pr_err("Error read GPIO pin mapping\n");
+		kfree(pins);
+		return ret;
+	}
+
 	gpio_dev->avail = 0;
 
 	for (i = 0 ; i <  GPIO_MAX_PINS ; i++) {
-		ret = check_pin(i);
-		if (ret)
+		int group, bit;
+		u16 map = pins->map[i];
+
+		if (pins->status[i] || (map & 0xFF) >= ARRAY_SIZE(group_map))
+			continue;
+
+		/* Check mapped pin */
+		group = group_map[map & 0xFF].group;
+		bit   = map >> 8;
+
+		if (group_status[group] || !(group_avail[group] & BIT(bit)))
 			continue;
 
 		gpio_dev->avail |= BIT(i);
@@ -220,7 +227,9 @@ static int gpio_init(void)
 		str[GPIO_MAX_PINS - i] = '1';
 	}
 
-	pr_info("GPIO pins=%s\n", str);
+	kfree(pins);
+
+	pr_info("EC%d GPIO pins=%s\n", gpio_dev->ec, str);
 
 	return gpio_dev->max ? 0 : -ENOTSUPP;
 }
@@ -240,6 +249,7 @@ static const struct gpio_chip eiois200_gpio_chip = {
 static int gpio_probe(struct platform_device *pdev)
 {
 	struct device *dev =  &pdev->dev;
+	struct _gpio_dev *gpio_dev;
 
 	eiois200_dev = dev_get_drvdata(dev->parent);
 	if (!eiois200_dev) {
@@ -248,12 +258,17 @@ static int gpio_probe(struct platform_device *pdev)
 	}
 
 	gpio_dev = devm_kzalloc(dev, sizeof(struct _gpio_dev), GFP_KERNEL);
+	if (!gpio_dev)
+		return -ENOMEM;
+
+	gpio_dev->ec = eiois200_cell_chip(dev);
 
-	if (gpio_init())
+	if (gpio_init(gpio_dev))
 		return -EIO;
 
 	gpio_dev->regmap      = dev_get_regmap(dev->parent, NULL);
 	gpio_dev->chip	      = eiois200_gpio_chip;
+	gpio_dev->chip.label  = dev_name(dev);
 	gpio_dev->chip.parent = dev->parent;
 	gpio_dev->chip.ngpio  = gpio_dev->max;
 
@@ -264,12 +279,14 @@ static int gpio_probe(struct platform_device *pdev)
 }
 
 static struct platform_driver gpio_driver = {
+	.probe	= gpio_probe,
 	.driver = {
-		.owner = THIS_MODULE,
-		.name  = KBUILD_MODNAME,
+		.owner	    = THIS_MODULE,
+		.name	    = KBUILD_MODNAME,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	}
 };
-module_platform_driver_probe(gpio_driver, gpio_probe);
+module_platform_driver(gpio_driver);
 
 MODULE_AUTHOR("Adavantech");
 MODULE_DESCRIPTION("GPIO driver for Advantech EIO-IS200 embedded controller");
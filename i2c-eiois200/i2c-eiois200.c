@@ -15,6 +15,7 @@
 #include <linux/mfd/eiois200.h>
 #include <linux/version.h>
 
+#include "i2c-eiois200_kunit.h"
 
 #define SUPPORTED_COMMON (I2C_FUNC_I2C | \
 			  I2C_FUNC_SMBUS_QUICK | \
@@ -27,14 +28,6 @@
 
 #define MAX_I2C_SMB		4
 
-#define REG_PNP_INDEX		0x299
-#define REG_PNP_DATA		0x29A
-#define REG_SUB_PNP_INDEX	0x499
-#define REG_SUB_PNP_DATA	0x49A
-#define REG_EXT_MODE_ENTER	0x87
-#define REG_EXT_MODE_EXIT	0xAA
-#define REG_LDN			0x07
-
 #define LDN_I2C0		0x20
 #define LDN_I2C1		0x21
 #define LDN_SMBUS0		0x22
@@ -507,27 +500,63 @@ static int read_data(struct dev_i2c *i2c, u8 *data)
 	return 0;
 }
 
+/*
+ * Prescaler values of @freq in kHz. The bus clock is the selected SCL
+ * high clock divided by (pre2 + 1), rounded down so the bus never runs
+ * faster than asked for.
+ */
+static int freq_to_prescale(int freq, u8 *pre1, u8 *pre2)
+{
+	u16 speed;
+
+	if (freq > I2C_FREQ_MAX || freq < I2C_FREQ_MIN)
+		return -EINVAL;
+
+	speed = freq < I2C_THRESHOLD_SCLH ? I2C_SCLH_LOW : I2C_SCLH_HIGH;
+
+	*pre1 = (u8)(CHIP_CLK / speed);
+	*pre2 = (u8)(DIV_ROUND_UP(speed, freq) - 1);
+
+	if (speed == I2C_SCLH_HIGH)
+		*pre2 |= I2C_SCL_FAST_MODE;
+
+	return 0;
+}
+
+/* Bus clock in kHz of a PRESCALE2 value */
+static int prescale_to_freq(u8 pre2)
+{
+	int clk = pre2 & I2C_SCL_FAST_MODE ? I2C_SCLH_HIGH : I2C_SCLH_LOW;
+
+	return clk / ((pre2 & ~I2C_SCL_FAST_MODE) + 1);
+}
+
+/*
+ * Address bytes of @msg as sent on the bus, the first one in bits 15:8 for
+ * a 10-bit address. The R/W bit is always in the first byte.
+ */
+static u16 msg_to_addr(const struct i2c_msg *msg)
+{
+	u16 rd = msg->flags & I2C_M_RD ? 1 : 0;
+
+	if (msg->flags & I2C_M_TEN)
+		return I2C_ENC_10BIT_ADDR(msg->addr) | rd << 8;
+
+	return I2C_ENC_7BIT_ADDR(msg->addr) | rd;
+}
+
 static int set_freq(struct dev_i2c *i2c, int freq)
 {
 	u8 pre1, pre2;
-	u16 speed;
 	int reg1 = IS_I2C(i2c) ? I2C_REG_PRESCALE1 : SMB_REG_HPRESCALE1;
 	int reg2 = IS_I2C(i2c) ? I2C_REG_PRESCALE2 : SMB_REG_HPRESCALE2;
 
 	dev_dbg(i2c->dev, "set freq: %dkHz\n", freq);
-	if (freq > I2C_FREQ_MAX || freq < I2C_FREQ_MIN) {
+	if (freq_to_prescale(freq, &pre1, &pre2)) {
 		dev_err(i2c->dev, "Invalid i2c freq: %d\n", freq);
 		return -EINVAL;
 	}
 
-	speed = freq < I2C_THRESHOLD_SCLH ? I2C_SCLH_LOW : I2C_SCLH_HIGH;
-
-	pre1 = (uint8_t)(CHIP_CLK / speed);
-	pre2 = (uint8_t)((speed / freq) - 1);
-
-	if (freq > I2C_THRESHOLD_SCLH)
-		pre2 |= I2C_SCL_FAST_MODE;
-
 	I2C_WRITE(i2c, reg1, pre1);
 	I2C_WRITE(i2c, reg2, pre2);
 
@@ -536,18 +565,12 @@ static int set_freq(struct dev_i2c *i2c, int freq)
 
 static int get_freq(struct dev_i2c *i2c, int *freq)
 {
-	int clk;
-	int pre1 = 0, pre2 = 0;
-	int reg1 = IS_I2C(i2c) ? I2C_REG_PRESCALE1 : SMB_REG_HPRESCALE1;
+	int pre2 = 0;
 	int reg2 = IS_I2C(i2c) ? I2C_REG_PRESCALE2 : SMB_REG_HPRESCALE2;
 
-	I2C_READ(i2c, reg1, &pre1);
 	I2C_READ(i2c, reg2, &pre2);
 
-	clk = pre2 & I2C_SCL_FAST_MODE ? I2C_SCLH_HIGH : I2C_SCLH_LOW;
-	pre2 &= ~I2C_SCL_FAST_MODE;
-
-	*freq = clk / (pre2 + 1);
+	*freq = prescale_to_freq(pre2);
 
 	return 0;
 }
@@ -745,18 +768,15 @@ static int i2c_xfer(struct i2c_adapter *adap, struct i2c_msg *msgs, int num)
 		if (!msgs[msg].len)
 			let_stop(i2c);
 
+		addr = msg_to_addr(&msgs[msg]);
 		if (msgs[msg].flags & I2C_M_TEN) {
-			addr = I2C_ENC_10BIT_ADDR(msgs[msg].addr);
-			addr |= is_read;
 			dev_dbg(i2c->dev, "10bits addr: %X\n", addr);
 
 			ret = write_addr(i2c, addr >> 8, no_ack);
 			if (!ret)
-				ret = write_data(i2c, addr & 0x7F,
+				ret = write_data(i2c, addr & 0xFF,
 						 no_ack);
 		} else {
-			addr = I2C_ENC_7BIT_ADDR(msgs[msg].addr);
-			addr |= is_read;
 			dev_dbg(i2c->dev, "7bits addr: %X\n", addr);
 
 			ret = write_addr(i2c, addr, no_ack);
@@ -902,33 +922,25 @@ static int smbus_xfer(struct i2c_adapter *adap, u16 addr,
 
 static int load_i2c(struct device *dev, enum i2c_ch ch, struct dev_i2c *i2c)
 {
-	u32 base_lo, base_hi, base;
-	int ldn = LDN_I2C0 + ch;
+	u32 base;
 	int *freqs[] = { &i2c0_freq, &i2c1_freq, &smb0_freq, &smb1_freq };
-	int *freq = freqs[ch];
-	struct eiois200_dev *eiois200_dev = dev_get_drvdata(dev->parent);
+	int sub_freq = USE_DEFAULT;
+	u8 ec = eiois200_cell_chip(dev);
+	struct pnp_op ops[] = {
+		{ .ldn = LDN_I2C0 + ch, .reg = REG_BASE_HI },
+		{ .ldn = LDN_I2C0 + ch, .reg = REG_BASE_LO },
+	};
 
-	mutex_lock(&eiois200_dev->mutex);
+	/* The frequency parameters apply to the main chip */
+	int *freq = ec ? &sub_freq : freqs[ch];
 
 	/* Get device I/O base address */
-	if (regmap_write(regmap, REG_PNP_INDEX, REG_EXT_MODE_ENTER) ||
-	    regmap_write(regmap, REG_PNP_INDEX, REG_EXT_MODE_ENTER) ||
-	    regmap_write(regmap, REG_PNP_INDEX, REG_LDN) ||
-	    regmap_write(regmap, REG_PNP_DATA, ldn) ||
-	    regmap_write(regmap, REG_PNP_INDEX, REG_BASE_HI) ||
-	    regmap_read(regmap, REG_PNP_DATA, &base_hi) ||
-	    regmap_write(regmap, REG_PNP_INDEX, REG_BASE_LO) ||
-	    regmap_read(regmap, REG_PNP_DATA, &base_lo) ||
-	    regmap_write(regmap, REG_PNP_INDEX, REG_EXT_MODE_EXIT)) {
-		mutex_unlock(&eiois200_dev->mutex);
-
+	if (eiois200_core_pnp_batch(dev, ec, ops, ARRAY_SIZE(ops))) {
 		dev_err(dev, "error read/write I2C[%d] IO port\n", ch);
 		return -EIO;
 	}
 
-	mutex_unlock(&eiois200_dev->mutex);
-
-	base = (base_hi << 8) | base_lo;
+	base = (ops[0].val << 8) | ops[1].val;
 	if (base == 0xFFFF || base == 0) {
 		dev_dbg(dev, "i2c[%d] base addr= %XH --> not inuse\n",
 			ch, base);
@@ -1011,7 +1023,8 @@ static int eiois200_i2c_probe(struct platform_device *pdev)
 		i2c->adap.dev.parent = dev;
 		rt_mutex_init(&i2c->lock);
 
-		sprintf(i2c->adap.name, "eiois200-%s", name[ch]);
+		sprintf(i2c->adap.name, "eiois200-%s%s",
+			eiois200_cell_chip(dev) ? "sub-" : "", name[ch]);
 		i2c_set_adapdata(&i2c->adap, i2c);
 
 		ret = i2c_add_numbered_adapter(&i2c->adap);
@@ -1079,6 +1092,7 @@ static struct platform_driver eiois200_i2c_driver = {
 	.probe = eiois200_i2c_probe,
 	.remove = eiois200_i2c_remove,
 	.driver.name = "i2c_eiois200",
+	.driver.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 };
 
 module_platform_driver(eiois200_i2c_driver);
@@ -1086,3 +1100,24 @@ module_platform_driver(eiois200_i2c_driver);
 MODULE_AUTHOR("Advantech");
 MODULE_DESCRIPTION("I2C driver for Advantech EIO-IS200 embedded controller");
 MODULE_LICENSE("GPL v2");
+
+#ifdef EIOIS200_KUNIT
+/* Hooks for i2c-eiois200_test, see i2c-eiois200_kunit.h */
+int eiois200_kunit_i2c_prescale(int freq, u8 *pre1, u8 *pre2)
+{
+	return freq_to_prescale(freq, pre1, pre2);
+}
+EXPORT_SYMBOL_GPL(eiois200_kunit_i2c_prescale);
+
+int eiois200_kunit_i2c_freq(u8 pre2)
+{
+	return prescale_to_freq(pre2);
+}
+EXPORT_SYMBOL_GPL(eiois200_kunit_i2c_freq);
+
+u16 eiois200_kunit_i2c_addr(const struct i2c_msg *msg)
+{
+	return msg_to_addr(msg);
+}
+EXPORT_SYMBOL_GPL(eiois200_kunit_i2c_addr);
+#endif
@@ -0,0 +1,20 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Hooks of i2c-eiois200 for the i2c-eiois200_test KUnit module.
+ *
+ * They are only built and exported with make KUNIT=y and give the test
+ * the bus encoders, which need no controller.
+ *
+ * Copyright (C) 2023 Advantech Co., Ltd.
+ */
+
+#ifndef _I2C_EIOIS200_KUNIT_H_
+#define _I2C_EIOIS200_KUNIT_H_
+
+#include <linux/i2c.h>
+
+int eiois200_kunit_i2c_prescale(int freq, u8 *pre1, u8 *pre2);
+int eiois200_kunit_i2c_freq(u8 pre2);
+u16 eiois200_kunit_i2c_addr(const struct i2c_msg *msg);
+
+#endif
@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit tests of the EIO-IS200 I2C and SMBus driver, built as the
+ * i2c-eiois200_test module with make KUNIT=y.
+ *
+ * The cases only cover the bus clock and address encoders, so they need
+ * neither the controller nor the software EC model.
+ *
+ * Copyright (C) 2023 Advantech Co., Ltd.
+ */
+
+#include <linux/errno.h>
+#include <linux/i2c.h>
+#include <linux/module.h>
+#include <kunit/test.h>
+
+#include "i2c-eiois200_kunit.h"
+
+#define FREQ_MIN	8	/* kHz, I2C_FREQ_MIN */
+#define FREQ_MAX	400	/* kHz, I2C_FREQ_MAX */
+#define FREQ_FAST	30	/* kHz, I2C_THRESHOLD_SCLH */
+#define FAST_MODE	0x80	/* I2C_SCL_FAST_MODE */
+
+static void test_freq_range(struct kunit *test)
+{
+	u8 pre1, pre2;
+
+	KUNIT_EXPECT_EQ(test, eiois200_kunit_i2c_prescale(FREQ_MIN - 1,
+							  &pre1, &pre2),
+			-EINVAL);
+	KUNIT_EXPECT_EQ(test, eiois200_kunit_i2c_prescale(FREQ_MAX + 1,
+							  &pre1, &pre2),
+			-EINVAL);
+	KUNIT_EXPECT_EQ(test, eiois200_kunit_i2c_prescale(FREQ_MIN,
+							  &pre1, &pre2), 0);
+	KUNIT_EXPECT_EQ(test, eiois200_kunit_i2c_prescale(FREQ_MAX,
+							  &pre1, &pre2), 0);
+}
+
+/* The SCL high clock and the fast mode bit switch at the same frequency */
+static void test_freq_mode(struct kunit *test)
+{
+	u8 pre1, pre2;
+
+	KUNIT_ASSERT_EQ(test, eiois200_kunit_i2c_prescale(FREQ_FAST - 1,
+							  &pre1, &pre2), 0);
+	KUNIT_EXPECT_EQ(test, pre1, 50);
+	KUNIT_EXPECT_FALSE(test, pre2 & FAST_MODE);
+
+	KUNIT_ASSERT_EQ(test, eiois200_kunit_i2c_prescale(FREQ_FAST,
+							  &pre1, &pre2), 0);
+	KUNIT_EXPECT_EQ(test, pre1, 20);
+	KUNIT_EXPECT_TRUE(test, pre2 & FAST_MODE);
+}
+
+/* What get_freq() reports back never exceeds what set_freq() was given */
+static void test_freq_round_trip(struct kunit *test)
+{
+	u8 pre1, pre2;
+	int freq, got;
+
+	for (freq = FREQ_MIN; freq <= FREQ_MAX; freq++) {
+		KUNIT_ASSERT_EQ(test, eiois200_kunit_i2c_prescale(freq, &pre1,
+								  &pre2), 0);
+
+		got = eiois200_kunit_i2c_freq(pre2);
+		KUNIT_EXPECT_LE_MSG(test, got, freq, "freq %d", freq);
+		KUNIT_EXPECT_GE_MSG(test, got * 7, freq * 6, "freq %d", freq);
+	}
+
+	/* Exact dividers */
+	eiois200_kunit_i2c_prescale(10, &pre1, &pre2);
+	KUNIT_EXPECT_EQ(test, eiois200_kunit_i2c_freq(pre2), 10);
+	eiois200_kunit_i2c_prescale(100, &pre1, &pre2);
+	KUNIT_EXPECT_EQ(test, eiois200_kunit_i2c_freq(pre2), 100);
+}
+
+static void test_addr_7bit(struct kunit *test)
+{
+	struct i2c_msg msg = { .addr = 0x50 };
+
+	KUNIT_EXPECT_EQ(test, eiois200_kunit_i2c_addr(&msg), 0xA0);
+
+	msg.flags = I2C_M_RD;
+	KUNIT_EXPECT_EQ(test, eiois200_kunit_i2c_addr(&msg), 0xA1);
+
+	msg.addr = 0x7F;
+	KUNIT_EXPECT_EQ(test, eiois200_kunit_i2c_addr(&msg), 0xFF);
+}
+
+/* 11110 A9 A8 R/W, then A7..A0 */
+static void test_addr_10bit(struct kunit *test)
+{
+	struct i2c_msg msg = { .addr = 0x123, .flags = I2C_M_TEN };
+
+	KUNIT_EXPECT_EQ(test, eiois200_kunit_i2c_addr(&msg), 0xF223);
+
+	msg.flags |= I2C_M_RD;
+	KUNIT_EXPECT_EQ(test, eiois200_kunit_i2c_addr(&msg), 0xF323);
+
+	msg.addr = 0x3FF;
+	KUNIT_EXPECT_EQ(test, eiois200_kunit_i2c_addr(&msg), 0xF7FF);
+
+	msg.addr  = 0x0A5;
+	msg.flags = I2C_M_TEN;
+	KUNIT_EXPECT_EQ(test, eiois200_kunit_i2c_addr(&msg), 0xF0A5);
+}
+
+static struct kunit_case i2c_eiois200_test_cases[] = {
+	KUNIT_CASE(test_freq_range),
+	KUNIT_CASE(test_freq_mode),
+	KUNIT_CASE(test_freq_round_trip),
+	KUNIT_CASE(test_addr_7bit),
+	KUNIT_CASE(test_addr_10bit),
+	{}
+};
+
+static struct kunit_suite i2c_eiois200_test_suite = {
+	.name	    = "i2c_eiois200",
+	.test_cases = i2c_eiois200_test_cases,
+};
+kunit_test_suite(i2c_eiois200_test_suite);
+
+MODULE_AUTHOR("Wenkai <advantech.susiteam@gmail.com>");
+MODULE_DESCRIPTION("KUnit tests of the Advantech EIO-IS200 I2C driver");
+MODULE_LICENSE("GPL v2");
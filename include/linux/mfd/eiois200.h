@@ -8,7 +8,10 @@
 
 #ifndef _MFD_EIOIS200_H_
 #define _MFD_EIOIS200_H_
+#include <linux/completion.h>
 #include <linux/io.h>
+#include <linux/ktime.h>
+#include <linux/list.h>
 #include <linux/regmap.h>
 #include <linux/thermal.h>
 #include <uapi/linux/thermal.h>
@@ -359,6 +362,51 @@ struct _pmc_port {
 	u16 data;
 };
 
+/**
+ * struct eiois200_pdata - Platform data of the child devices
+ * @chip:	0 for main chip, 1 for sub chip.
+ *
+ * The core registers one set of child devices per detected EC.
+ */
+struct eiois200_pdata {
+	u8 chip;
+};
+
+/**
+ * eiois200_cell_chip - The EC a child device belongs to
+ * @dev:	The child device.
+ *
+ * Sub-drivers set &pmc_op.chip to it.
+ */
+static inline u8 eiois200_cell_chip(struct device *dev)
+{
+	const struct eiois200_pdata *pdata = dev_get_platdata(dev);
+
+	return pdata ? pdata->chip : 0;
+}
+
+/* PMC request priorities, see &pmc_op.priority */
+enum eiois200_pmc_prio {
+	PMC_PRIO_INTERACTIVE,	/* Default. sysfs and user space requests */
+	PMC_PRIO_CRITICAL,	/* Watchdog, served at next transaction boundary */
+	PMC_PRIO_BACKGROUND,	/* Sampling and discovery */
+	PMC_PRIO_NUM,
+};
+
+/* Originator of a PMC request, see &pmc_op.client */
+enum eiois200_client {
+	EIOIS200_CLIENT_CORE,	/* Default. Core sysfs and sampling */
+	EIOIS200_CLIENT_HWMON,
+	EIOIS200_CLIENT_THERMAL,
+	EIOIS200_CLIENT_FAN,
+	EIOIS200_CLIENT_GPIO,
+	EIOIS200_CLIENT_PNP,	/* PNP configuration accesses, e.g. I2C */
+	EIOIS200_CLIENT_WDT,
+	EIOIS200_CLIENT_BL,
+	EIOIS200_CLIENT_CHARDEV, /* /dev/eiois200 */
+	EIOIS200_CLIENT_NUM,
+};
+
 struct pmc_op {
 	u8  cmd;
 	u8  control;
@@ -367,6 +415,10 @@ struct pmc_op {
 	u8  *payload;
 	u8  chip;
 	u16 timeout;
+	u8  priority;
+	u16 ttl;	/* Read cache lifetime in msec, 0 for no cache */
+	bool persist;	/* Write to keep across power cycles, see save_ms */
+	u8  client;	/* enum eiois200_client, see client_rate */
 };
 
 enum eiois200_rw_operation {
@@ -379,17 +431,299 @@ struct eiois200_dev {
 
 	struct _pmc_port  pmc[EIOIS200_EC_NUM];
 
-	struct mutex mutex; /* Protects PMC command access */
+	struct mutex mutex; /* Protects PNP index/data port sequences */
+	struct mutex pmc_mutex[EIOIS200_EC_NUM]; /* Protects PMC command access per chip */
 };
 
+/**
+ * eiois200_chip_exist - Check if an EC is present
+ * @eiois200:	The eiois200_core device data.
+ * @chip:	0 for main chip, 1 for sub chip.
+ *
+ * Sub-drivers may target either chip by setting &pmc_op.chip to an index
+ * for which this returns true.
+ */
+static inline bool eiois200_chip_exist(struct eiois200_dev *eiois200, int chip)
+{
+	if (chip < 0 || chip >= EIOIS200_EC_NUM)
+		return false;
+
+	return eiois200->flag & (chip ? EIOIS200_F_SUB_CHIP_EXIST :
+					EIOIS200_F_CHIP_EXIST);
+}
+
 /**
  * eiois200_core_pmc_operation - Execute a new pmc command
  * @dev:	The device structure pointer.
  * @op:		Pointer to an new pmc command.
+ *
+ * Returns -EBUSY when &pmc_op.client is over its client_rate limit.
  */
 int eiois200_core_pmc_operation(struct device *dev,
 				struct pmc_op *operation);
 
+/**
+ * struct pmc_request - An asynchronous PMC request
+ * @ops:	PMC commands executed under one lock hold, all on the same chip.
+ * @num:	Number of commands in @ops.
+ * @status:	Optional array of @num results, one per command.
+ * @priority:	One of &enum eiois200_pmc_prio.
+ * @result:	0 or the first error. Valid on completion.
+ * @complete:	Called from the chip worker on completion. May be NULL.
+ * @context:	Caller data for @complete.
+ * @done:	Completed on completion if @complete is NULL.
+ * @dev:	Internal. The submitter device.
+ * @node:	Internal. Chip queue node.
+ * @queued:	Internal. Time of submission.
+ * @followers:	Internal. Identical reads completed with this one.
+ */
+struct pmc_request {
+	struct pmc_op	 *ops;
+	uint		 num;
+	int		 *status;
+	u8		 priority;
+	int		 result;
+	void		 (*complete)(struct pmc_request *req);
+	void		 *context;
+	struct completion done;
+
+	struct device	 *dev;
+	struct list_head node;
+	ktime_t		 queued;
+	struct list_head followers;
+};
+
+/**
+ * eiois200_core_pmc_submit - Queue PMC commands to the chip worker
+ * @dev:	The device structure pointer.
+ * @req:	The request to queue.
+ */
+int eiois200_core_pmc_submit(struct device *dev, struct pmc_request *req);
+
+/**
+ * eiois200_core_pmc_batch - Execute PMC commands under one lock hold
+ * @dev:	The device structure pointer.
+ * @ops:	Array of PMC commands, all targeting the same chip.
+ * @num:	Number of commands in @ops.
+ * @status:	Optional array of @num results, one per command.
+ *
+ * The whole batch is charged to the client of the first command. If it is
+ * rejected before any command is sent, every @status entry gets the error.
+ */
+int eiois200_core_pmc_batch(struct device *dev,
+			    struct pmc_op *ops,
+			    uint num,
+			    int *status);
+
+/**
+ * eiois200_batch_rejected - Check if a batch was rejected before sending
+ * @ret:	The return value of eiois200_core_pmc_batch().
+ * @status:	Its @status array.
+ * @num:	Its number of commands.
+ *
+ * Otherwise @status tells which commands failed, and the others can be
+ * used.
+ */
+static inline bool eiois200_batch_rejected(int ret, const int *status,
+					   uint num)
+{
+	uint i;
+
+	if (!ret)
+		return false;
+
+	for (i = 0; i < num; i++)
+		if (status[i] != ret)
+			return false;
+
+	return true;
+}
+
+/*
+ * Typed PMC accessors
+ *
+ * The caller's &struct pmc_op names the target: cmd, control, device_id,
+ * chip and optionally timeout, ttl and priority. The accessor fills in size
+ * and payload from the value type, so the size is a compile time constant
+ * and a mismatched value pointer fails to build:
+ *
+ *	u16 temp;
+ *	struct pmc_op op = { .cmd = 0x11, .control = 0x10, .device_id = ch };
+ *
+ *	ret = eiois200_pmc_read(dev, &op, &temp);
+ */
+#define EIOIS200_PMC_TYPES(X)	X(u8) X(u16) X(u32)
+
+#define EIOIS200_PMC_ACCESSORS(type)					\
+static inline int eiois200_pmc_read_##type(struct device *dev,		\
+					   const struct pmc_op *op,	\
+					   type *val)			\
+{									\
+	struct pmc_op rd = *op;						\
+									\
+	rd.size	   = sizeof(type);					\
+	rd.payload = (u8 *)val;						\
+									\
+	return eiois200_core_pmc_operation(dev, &rd);			\
+}									\
+									\
+static inline int eiois200_pmc_write_##type(struct device *dev,	\
+					    const struct pmc_op *op,	\
+					    type val)			\
+{									\
+	struct pmc_op wr = *op;						\
+									\
+	wr.size	   = sizeof(type);					\
+	wr.payload = (u8 *)&val;					\
+									\
+	return eiois200_core_pmc_operation(dev, &wr);			\
+}
+
+EIOIS200_PMC_TYPES(EIOIS200_PMC_ACCESSORS)
+
+#undef EIOIS200_PMC_ACCESSORS
+
+/**
+ * eiois200_pmc_read_block - Read a payload of a given length
+ * @dev:	The device structure pointer.
+ * @op:		The target command, size and payload are ignored.
+ * @buf:	Destination of @len bytes.
+ * @len:	Payload length.
+ */
+static inline int eiois200_pmc_read_block(struct device *dev,
+					  const struct pmc_op *op,
+					  void *buf, u8 len)
+{
+	struct pmc_op rd = *op;
+
+	rd.size	   = len;
+	rd.payload = buf;
+
+	return eiois200_core_pmc_operation(dev, &rd);
+}
+
+/**
+ * eiois200_pmc_write_block - Write a payload of a given length
+ * @dev:	The device structure pointer.
+ * @op:		The target command, size and payload are ignored.
+ * @buf:	Source of @len bytes.
+ * @len:	Payload length.
+ */
+static inline int eiois200_pmc_write_block(struct device *dev,
+					   const struct pmc_op *op,
+					   const void *buf, u8 len)
+{
+	struct pmc_op wr = *op;
+
+	wr.size	   = len;
+	wr.payload = (u8 *)buf;
+
+	return eiois200_core_pmc_operation(dev, &wr);
+}
+
+/* Pick the accessor from the type of the value pointer, or the value */
+#define eiois200_pmc_read(dev, op, val)			\
+	_Generic((val),					\
+		 u8 *:	eiois200_pmc_read_u8,		\
+		 u16 *:	eiois200_pmc_read_u16,		\
+		 u32 *:	eiois200_pmc_read_u32)(dev, op, val)
+
+#define eiois200_pmc_write(dev, op, val)		\
+	_Generic((val),					\
+		 u8:	eiois200_pmc_write_u8,		\
+		 u16:	eiois200_pmc_write_u16,		\
+		 u32:	eiois200_pmc_write_u32)(dev, op, val)
+
+/* Payload size of a typed value pointer, for batch operations */
+#define EIOIS200_PMC_SIZE(val)				\
+	_Generic((val),					\
+		 u8 *:	sizeof(u8),			\
+		 u16 *:	sizeof(u16),			\
+		 u32 *:	sizeof(u32))
+
+/**
+ * struct pnp_op - One PNP configuration register access
+ * @ldn:	Logical device number. Not used for the global registers
+ *		below 0x30.
+ * @reg:	Configuration register.
+ * @val:	Value to write, or the value read.
+ * @write:	True to write @val.
+ */
+struct pnp_op {
+	u8   ldn;
+	u8   reg;
+	u8   val;
+	bool write;
+};
+
+/**
+ * eiois200_core_pnp_batch - Access PNP configuration registers of an EC
+ * @dev:	The device structure pointer.
+ * @chip:	0 for main chip, 1 for sub chip.
+ * @ops:	Accesses, in order. Reads return their value in &pnp_op.val.
+ * @num:	Number of accesses in @ops.
+ *
+ * The configuration space is entered at most once per call. Activation,
+ * I/O base and IRQ registers of a logical device are cached by the core,
+ * so reading them again does not touch the ports.
+ */
+int eiois200_core_pnp_batch(struct device *dev, u8 chip,
+			    struct pnp_op *ops, uint num);
+
+static inline int eiois200_core_pnp_read(struct device *dev, u8 chip,
+					 u8 ldn, u8 reg, u8 *val)
+{
+	struct pnp_op op = { .ldn = ldn, .reg = reg };
+	int ret;
+
+	ret = eiois200_core_pnp_batch(dev, chip, &op, 1);
+	if (!ret)
+		*val = op.val;
+
+	return ret;
+}
+
+static inline int eiois200_core_pnp_write(struct device *dev, u8 chip,
+					  u8 ldn, u8 reg, u8 val)
+{
+	struct pnp_op op = { .ldn = ldn, .reg = reg, .val = val, .write = true };
+
+	return eiois200_core_pnp_batch(dev, chip, &op, 1);
+}
+
+/* Sensor values kept in the core snapshot table, see eiois200_core_snapshot() */
+enum eiois200_snap {
+	EIOIS200_SNAP_TEMP,	/* Thermal channel value, 0.1 Kelvin */
+	EIOIS200_SNAP_VOLT,	/* Voltage channel value, 0.01 V */
+	EIOIS200_SNAP_FAN_CTRL,	/* Smart fan control byte */
+	EIOIS200_SNAP_NUM,
+};
+
+#define EIOIS200_SNAP_CH	16
+
+/**
+ * eiois200_core_snapshot - Read a sensor value from the snapshot table
+ * @dev:	The device structure pointer.
+ * @chip:	0 for main chip, 1 for sub chip.
+ * @type:	One of &enum eiois200_snap.
+ * @ch:		Channel, less than %EIOIS200_SNAP_CH.
+ * @val:	The raw value, as returned by the EC.
+ * @client:	Client charged when the value has to be read live.
+ */
+int eiois200_core_snapshot(struct device *dev, u8 chip,
+			   enum eiois200_snap type, u8 ch, u16 *val,
+			   enum eiois200_client client);
+
+/**
+ * eiois200_core_cfg_sync - Save pending persistent settings now
+ * @dev:	The device structure pointer.
+ *
+ * Writes with &pmc_op.persist set are saved to the EC flash once the
+ * chip has been quiet for a while. This issues the pending saves without
+ * waiting for that, e.g. before a reboot.
+ */
+int eiois200_core_cfg_sync(struct device *dev);
+
 enum eiois200_pmc_wait {
 	PMC_WAIT_INPUT,
 	PMC_WAIT_OUTPUT,
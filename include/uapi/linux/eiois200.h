@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: GPL-2.0-only WITH Linux-syscall-note */
+/*
+ * User space interface of the Advantech EIO-IS200 Series EC base Driver
+ *
+ * /dev/eiois200 runs a vector of PMC commands in one locked batch:
+ *
+ *	struct eiois200_pmc_xfer xfer[2] = {
+ *		{ .cmd = 0x53, .control = 0x21, .size = 4 },
+ *		{ .cmd = 0x55, .control = 0x10, .size = 4 },
+ *	};
+ *	struct eiois200_pmc_batch batch = {
+ *		.num   = 2,
+ *		.xfers = (uintptr_t)xfer,
+ *	};
+ *
+ *	ioctl(fd, EIOIS200_IOC_PMC_BATCH, &batch);
+ *
+ * Each xfer gets its own status. Read results are returned in data[].
+ *
+ * Copyright (C) 2023 Advantech Co., Ltd.
+ */
+
+#ifndef _UAPI_LINUX_EIOIS200_H
+#define _UAPI_LINUX_EIOIS200_H
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+#define EIOIS200_PMC_XFER_DATA	32
+#define EIOIS200_PMC_BATCH_MAX	64
+
+/**
+ * struct eiois200_pmc_xfer - One PMC command
+ * @cmd:	PMC command. Odd commands are reads.
+ * @control:	Control byte.
+ * @device_id:	Device id byte.
+ * @size:	Payload size, up to %EIOIS200_PMC_XFER_DATA.
+ * @chip:	0 for main chip, 1 for sub chip. Same for all xfers of a batch.
+ * @reserved:	Must be zero.
+ * @status:	Returned 0 or a negative errno of this command.
+ * @data:	Payload written, or read back.
+ */
+struct eiois200_pmc_xfer {
+	__u8  cmd;
+	__u8  control;
+	__u8  device_id;
+	__u8  size;
+	__u8  chip;
+	__u8  reserved[3];
+	__s32 status;
+	__u8  data[EIOIS200_PMC_XFER_DATA];
+};
+
+/**
+ * struct eiois200_pmc_batch - Argument of %EIOIS200_IOC_PMC_BATCH
+ * @num:	Number of xfers, up to %EIOIS200_PMC_BATCH_MAX.
+ * @reserved:	Must be zero.
+ * @xfers:	User pointer to an array of struct eiois200_pmc_xfer.
+ */
+struct eiois200_pmc_batch {
+	__u32 num;
+	__u32 reserved;
+	__u64 xfers;
+};
+
+#define EIOIS200_IOC_MAGIC	'E'
+#define EIOIS200_IOC_PMC_BATCH	_IOWR(EIOIS200_IOC_MAGIC, 0x01, struct eiois200_pmc_batch)
+
+#endif /* _UAPI_LINUX_EIOIS200_H */